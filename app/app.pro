@@ -0,0 +1,35 @@
+include(../scrcap.pri)
+
+QT += widgets dbus
+
+TARGET = scrcap
+TEMPLATE = app
+
+LIBS += -L$$OUT_PWD/../core -lscrcapcore
+PRE_TARGETDEPS += $$OUT_PWD/../core/libscrcapcore.a
+
+SOURCES += main.cpp \
+    gstplayer.cpp \
+    mainwindow.cpp \
+    funcs.cpp \
+    windowgrabber.cpp \
+    regiongrabber.cpp \
+    headlesscapture.cpp \
+    captureservice.cpp \
+    qxtglobalshortcut.cpp
+
+FORMS += \
+    mainwindow.ui
+
+HEADERS += \
+    gstplayer.h \
+    mainwindow.h \
+    funcs.h \
+    windowgrabber.h \
+    regiongrabber.h \
+    headlesscapture.h \
+    captureservice.h \
+    qxtglobalshortcut.h
+
+DISTFILES += \
+    ../README.md
@@ -0,0 +1,259 @@
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDebug>
+
+#include <cerrno>
+#include <cstring>
+
+extern "C" {
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+}
+
+#include "captureservice.h"
+#include "funcs.h"
+
+namespace {
+const char *serviceName = "org.kernel1024.scrcap";
+const char *objectPath = "/Capture";
+const char *interfaceName = "org.kernel1024.scrcap.Capture";
+const int minInterval = 10;
+}
+
+ZCaptureService::ZCaptureService(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_engine,&ZCaptureEngine::frameCaptured,this,&ZCaptureService::autocaptureFrame);
+    connect(&m_engine,&ZCaptureEngine::autocaptureFailed,this,[this](const QString &message){
+        qWarning() << QSL("D-Bus autocapture: %1").arg(message);
+        finishAutocapture();
+    });
+
+    // autocapture of a client gone from the bus is stopped
+    m_clientWatcher.setConnection(QDBusConnection::sessionBus());
+    m_clientWatcher.setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
+    connect(&m_clientWatcher,&QDBusServiceWatcher::serviceUnregistered,this,&ZCaptureService::clientUnregistered);
+}
+
+ZCaptureService::~ZCaptureService()
+{
+    if (!m_registered) return;
+
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    bus.unregisterObject(QString::fromLatin1(objectPath));
+    bus.unregisterService(QString::fromLatin1(serviceName));
+}
+
+bool ZCaptureService::registerService()
+{
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    if (!bus.isConnected()) {
+        qWarning() << "D-Bus session bus not available, capture service disabled";
+        return false;
+    }
+
+    if (!bus.registerService(QString::fromLatin1(serviceName))) {
+        qWarning() << "Unable to register D-Bus service" << serviceName << "-" << bus.lastError().message();
+        return false;
+    }
+
+    if (!bus.registerObject(QString::fromLatin1(objectPath), this,
+                            QDBusConnection::ExportScriptableSlots | QDBusConnection::ExportScriptableSignals)) {
+        qWarning() << "Unable to register D-Bus capture object" << bus.lastError().message();
+        bus.unregisterService(QString::fromLatin1(serviceName));
+        return false;
+    }
+
+    m_registered = true;
+    qInfo() << "D-Bus capture service registered as" << serviceName;
+    return true;
+}
+
+// Error replies make sense for the bus callers only
+void ZCaptureService::replyError(QDBusError::ErrorType type, const QString &message)
+{
+    if (calledFromDBus()) {
+        sendErrorReply(type, message);
+    } else {
+        qWarning() << message;
+    }
+}
+
+// Frames are private to the client, other bus clients never see them
+void ZCaptureService::sendToClient(const QString &signalName, const QVariantList &arguments)
+{
+    if (m_autocaptureClient.isEmpty()) return;
+
+    QDBusMessage message = QDBusMessage::createTargetedSignal(m_autocaptureClient,
+                                                              QString::fromLatin1(objectPath),
+                                                              QString::fromLatin1(interfaceName),
+                                                              signalName);
+    message.setArguments(arguments);
+    if (!QDBusConnection::sessionBus().send(message))
+        qWarning() << "Unable to send D-Bus" << signalName << "to" << m_autocaptureClient;
+}
+
+// Tells the client its autocapture is over and forgets it
+void ZCaptureService::finishAutocapture()
+{
+    m_engine.stopAutocapture();
+    sendToClient(QSL("AutocaptureStopped"), QVariantList());
+    m_clientWatcher.setWatchedServices(QStringList());
+    m_autocaptureClient.clear();
+}
+
+void ZCaptureService::clientUnregistered(const QString &service)
+{
+    if (service != m_autocaptureClient) return;
+
+    qInfo() << "D-Bus autocapture client" << service << "disconnected";
+    m_engine.stopAutocapture();
+    m_clientWatcher.setWatchedServices(QStringList());
+    m_autocaptureClient.clear();
+}
+
+bool ZCaptureService::checkFdSupport()
+{
+    const QDBusConnection bus = calledFromDBus() ? connection() : QDBusConnection::sessionBus();
+    if (QDBusUnixFileDescriptor::isSupported() &&
+            bus.connectionCapabilities().testFlag(QDBusConnection::UnixFileDescriptorPassing))
+        return true;
+
+    replyError(QDBusError::NotSupported, QSL("Unix file descriptor passing is not supported"));
+    return false;
+}
+
+// Copies the frame into a new sealed memfd, the descriptor owns it
+QDBusUnixFileDescriptor ZCaptureService::frameDescriptor(const QImage &image, int *width, int *height, int *stride)
+{
+    QImage frame = image;
+    if (frame.format() != QImage::Format_RGB32 && frame.format() != QImage::Format_ARGB32 &&
+            frame.format() != QImage::Format_ARGB32_Premultiplied) {
+        frame = frame.convertToFormat(QImage::Format_ARGB32);
+    }
+
+    const int lineSize = frame.width() * 4;
+    const size_t size = static_cast<size_t>(lineSize) * static_cast<size_t>(frame.height());
+    if (size == 0) return QDBusUnixFileDescriptor();
+
+    const int fd = memfd_create("scrcap-frame", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        qWarning() << "Unable to create memfd for frame:" << strerror(errno);
+        return QDBusUnixFileDescriptor();
+    }
+
+    void *addr = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0)
+        addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (addr == MAP_FAILED) { // NOLINT
+        qWarning() << "Unable to map memfd for frame:" << strerror(errno);
+        close(fd);
+        return QDBusUnixFileDescriptor();
+    }
+
+    auto *dst = static_cast<uchar *>(addr);
+    for (int y = 0; y < frame.height(); y++)
+        memcpy(dst + static_cast<size_t>(y) * lineSize, frame.constScanLine(y), static_cast<size_t>(lineSize)); // NOLINT
+    munmap(addr, size);
+
+    // receivers can map the frame without fear of it changing or shrinking,
+    // an unsealed frame is never handed out
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) { // NOLINT
+        qWarning() << "Unable to seal memfd frame:" << strerror(errno);
+        close(fd);
+        return QDBusUnixFileDescriptor();
+    }
+
+    *width = frame.width();
+    *height = frame.height();
+    *stride = lineSize;
+
+    QDBusUnixFileDescriptor res;
+    res.giveFileDescriptor(fd);
+    return res;
+}
+
+QDBusUnixFileDescriptor ZCaptureService::Capture(int mode, const QRect &rect, bool includePointer,
+                                                 int &width, int &height, int &stride)
+{
+    width = 0;
+    height = 0;
+    stride = 0;
+
+    if (!checkFdSupport()) return QDBusUnixFileDescriptor();
+
+    if (mode < ZCaptureEngine::FullScreen || mode > ZCaptureEngine::Region ||
+            (mode == ZCaptureEngine::Region && rect.isEmpty())) {
+        replyError(QDBusError::InvalidArgs, QSL("Invalid capture mode or region"));
+        return QDBusUnixFileDescriptor();
+    }
+
+    QRect region;
+    const QImage image = ZCaptureEngine::grab(static_cast<ZCaptureEngine::ZCaptureMode>(mode), rect,
+                                              includePointer, true, &region).toImage();
+    const QDBusUnixFileDescriptor res = frameDescriptor(image, &width, &height, &stride);
+    if (!res.isValid())
+        replyError(QDBusError::Failed, QSL("Unable to capture"));
+
+    return res;
+}
+
+bool ZCaptureService::StartAutocapture(const QRect &rect, int interval, bool includePointer)
+{
+    if (!calledFromDBus()) {
+        qWarning() << "D-Bus autocapture frames can be delivered to a bus caller only";
+        return false;
+    }
+
+    if (!checkFdSupport()) return false;
+
+    if (rect.isEmpty() || interval < minInterval) {
+        replyError(QDBusError::InvalidArgs, QSL("Invalid autocapture region or interval"));
+        return false;
+    }
+
+    // a new caller takes over the autocapture
+    if (m_engine.isAutocaptureActive())
+        finishAutocapture();
+
+    m_autocaptureClient = message().service();
+    m_clientWatcher.setWatchedServices({ m_autocaptureClient });
+
+    // every changed frame is sent at once, clients throttle with the interval
+    ZCaptureEngine::ZCaptureSettings settings;
+    settings.mode = ZCaptureEngine::Region;
+    settings.region = rect;
+    settings.includePointer = includePointer;
+    settings.autocaptureInterval = interval;
+    settings.autocaptureWait = false;
+    m_engine.setSettings(settings);
+    m_engine.startAutocapture(rect, true);
+
+    qInfo() << "D-Bus autocapture started for" << m_autocaptureClient << "region" << rect;
+    return true;
+}
+
+void ZCaptureService::StopAutocapture()
+{
+    if (!m_engine.isAutocaptureActive()) return;
+
+    if (calledFromDBus() && message().service() != m_autocaptureClient) {
+        replyError(QDBusError::AccessDenied, QSL("Autocapture was started by another client"));
+        return;
+    }
+
+    finishAutocapture();
+}
+
+// The frame is a capture buffer view with the pointer already blended, copied only into the memfd
+void ZCaptureService::autocaptureFrame(const QImage &frame)
+{
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    const QDBusUnixFileDescriptor fd = frameDescriptor(frame, &width, &height, &stride);
+    if (fd.isValid())
+        sendToClient(QSL("FrameCaptured"), { QVariant::fromValue(fd), width, height, stride });
+}
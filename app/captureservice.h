@@ -0,0 +1,58 @@
+#ifndef CAPTURESERVICE_H
+#define CAPTURESERVICE_H
+
+#include <QObject>
+#include <QImage>
+#include <QRect>
+#include <QDBusContext>
+#include <QDBusError>
+#include <QDBusUnixFileDescriptor>
+#include <QDBusServiceWatcher>
+
+#include "captureengine.h"
+
+// Session bus capture service. Frames are handed over as sealed memfd file
+// descriptors holding 32 bpp ARGB pixels in native byte order, stride bytes
+// per line, so the pixel data never goes through the bus itself. Autocapture
+// frames are unicast to the client that started the autocapture.
+class ZCaptureService : public QObject, protected QDBusContext
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kernel1024.scrcap.Capture")
+private:
+    Q_DISABLE_COPY(ZCaptureService)
+
+    ZCaptureEngine m_engine;
+    QDBusServiceWatcher m_clientWatcher;
+    QString m_autocaptureClient;
+    bool m_registered { false };
+
+    static QDBusUnixFileDescriptor frameDescriptor(const QImage &image, int *width, int *height, int *stride);
+    bool checkFdSupport();
+    void replyError(QDBusError::ErrorType type, const QString &message);
+    void sendToClient(const QString &signalName, const QVariantList &arguments);
+    void finishAutocapture();
+
+public:
+    explicit ZCaptureService(QObject *parent = nullptr);
+    ~ZCaptureService() override;
+
+    bool registerService();
+
+public Q_SLOTS:
+    Q_SCRIPTABLE QDBusUnixFileDescriptor Capture(int mode, const QRect &rect, bool includePointer,
+                                                 int &width, int &height, int &stride);
+    Q_SCRIPTABLE bool StartAutocapture(const QRect &rect, int interval, bool includePointer);
+    Q_SCRIPTABLE void StopAutocapture();
+
+private Q_SLOTS:
+    void autocaptureFrame(const QImage &frame);
+    void clientUnregistered(const QString &service);
+
+Q_SIGNALS:
+    // Declared for introspection only, sendToClient() delivers them
+    Q_SCRIPTABLE void FrameCaptured(const QDBusUnixFileDescriptor &frame, int width, int height, int stride);
+    Q_SCRIPTABLE void AutocaptureStopped();
+};
+
+#endif // CAPTURESERVICE_H
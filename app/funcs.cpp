@@ -1,5 +1,3 @@
-#include <QDir>
-#include <QDateTime>
 #include <QDBusInterface>
 #include <QDBusArgument>
 #include <QDBusMetaType>
@@ -53,7 +51,34 @@ const QStringList &ZGenericFuncs::zCaptureMode() {
 const QStringList &ZGenericFuncs::zImageFormats() {
     static const QStringList res = {
         QSL("PNG"),
-        QSL("JPG")
+        QSL("JPG"),
+        QSL("QOI"),
+        QSL("WEBP")
+    };
+    return res;
+}
+
+const QStringList &ZGenericFuncs::zEncoderPolicies() {
+    static const QStringList res = {
+        QSL("Wait for free slot"),
+        QSL("Drop new snapshot"),
+        QSL("Drop oldest snapshot")
+    };
+    return res;
+}
+
+const QStringList &ZGenericFuncs::zRecordFormats() {
+    static const QStringList res = {
+        QSL("MP4 (H.264)"),
+        QSL("WebM (VP8)")
+    };
+    return res;
+}
+
+const QStringList &ZGenericFuncs::zAnimationFormats() {
+    static const QStringList res = {
+        QSL("Animated PNG"),
+        QSL("Animated WebP")
     };
     return res;
 }
@@ -132,60 +157,6 @@ QString ZGenericFuncs::getExistingDirectoryD ( QWidget * parent, const QString &
     return QFileDialog::getExistingDirectory(parent,caption,dir,options);
 }
 
-QString ZGenericFuncs::generateUniqName(QSpinBox *counter, const QString& tmpl, const QPixmap& snapshot, const QString &dir,
-                                        const QString& format, bool withoutPath)
-{
-    const int numberBase = 10;
-
-    counter->setValue(counter->value() + 1);
-
-    QString uniq = tmpl;
-    if (uniq.isEmpty())
-        uniq = QSL("%NN");
-
-    QRegularExpression exp(QSL("%(\\w+)"));
-    QRegularExpressionMatch mexp = exp.match(uniq);
-    for (int i=0; i < mexp.lastCapturedIndex(); i++) {
-        const int length = mexp.capturedLength(i);
-        const int pos = mexp.capturedStart(i);
-        if (length>=2) {
-            const QString tl = uniq.mid(pos+1,length-1);
-            if (tl.contains(QRegularExpression(QSL("N+")))) {
-                uniq.replace(pos, length, QSL("%1").arg(counter->value(),tl.length(),numberBase,QChar('0')));
-            } else if (tl == QSL("w")) {
-                uniq.replace(pos, length, QSL("%1").arg(snapshot.width()));
-            } else if (tl == QSL("h")) {
-                uniq.replace(pos, length, QSL("%1").arg(snapshot.height()));
-            } else if (tl == QSL("y")) {
-                uniq.replace(pos, length, QDateTime::currentDateTime().toString(QSL("yyyy")));
-            } else if (tl == QSL("m")) {
-                uniq.replace(pos, length, QDateTime::currentDateTime().toString(QSL("MM")));
-            } else if (tl == QSL("d")) {
-                uniq.replace(pos, length, QDateTime::currentDateTime().toString(QSL("dd")));
-            } else if (tl == QSL("t")) {
-                uniq.replace(pos, length, QDateTime::currentDateTime().toString(QSL("hh-mm-ss")));
-            }
-        }
-    }
-
-    QDir d(dir);
-    QString ext;
-    if (!format.isEmpty())
-        ext = QSL(".%1").arg(format.toLower());
-
-    QFileInfo fi(d.absoluteFilePath(QSL("%1%2").arg(uniq,ext)));
-    int idx = 1;
-    while (fi.exists()) {
-        fi.setFile(d.absoluteFilePath(QSL("%1-%3%2").arg(uniq,ext).arg(idx)));
-        idx++;
-    }
-
-    if (withoutPath)
-        return fi.fileName();
-
-    return fi.absoluteFilePath();
-}
-
 QString ZGenericFuncs::generateFilter(const QStringList &ext)
 {
     QString filter;
@@ -199,6 +170,32 @@ QString ZGenericFuncs::generateFilter(const QStringList &ext)
     return filter;
 }
 
+// Parses "x,y,w,h; x,y,w,h" lists, invalid entries are skipped
+QVector<QRect> ZGenericFuncs::parseRectList(const QString &text)
+{
+    const int rectFields = 4;
+
+    QVector<QRect> res;
+    const QStringList items = text.split(QSL(";"),Qt::SkipEmptyParts);
+    for (const auto &item : items) {
+        const QStringList fields = item.split(QSL(","),Qt::SkipEmptyParts);
+        if (fields.count() != rectFields) continue;
+
+        bool ok = true;
+        QVector<int> values;
+        for (const auto &field : fields) {
+            bool fieldOk = false;
+            values.append(field.trimmed().toInt(&fieldOk));
+            ok = ok && fieldOk;
+        }
+
+        const QRect rect(values.at(0),values.at(1),values.at(2),values.at(3));
+        if (ok && !rect.isEmpty())
+            res.append(rect);
+    }
+    return res;
+}
+
 struct iiibiiay
 {
     explicit iiibiiay(const QImage& pic);
@@ -4,11 +4,13 @@
 #include <QObject>
 #include <QString>
 #include <QFileDialog>
-#include <QSpinBox>
 #include <QStringList>
 #include <QWidget>
+#include <QVector>
+#include <QRect>
+#include <QSize>
 
-#define QSL QStringLiteral
+#include "coredefs.h"
 
 class ZGenericFuncs : public QObject
 {
@@ -21,6 +23,9 @@ public:
 
     static const QStringList &zCaptureMode();
     static const QStringList &zImageFormats();
+    static const QStringList &zEncoderPolicies();
+    static const QStringList &zRecordFormats();
+    static const QStringList &zAnimationFormats();
     static QStringList getSuffixesFromFilter(const QString& filter);
 
     static QString getOpenFileNameD(QWidget * parent = nullptr, const QString & caption = QString(),
@@ -42,10 +47,8 @@ public:
                                                                         QFileDialog::DontUseNativeDialog |
                                                                         QFileDialog::DontUseCustomDirectoryIcons);
 
-    static QString generateUniqName(QSpinBox* counter, const QString& tmpl, const QPixmap &snapshot, const QString &dir,
-                                    const QString &format = QString(), bool withoutPath = true);
-
     static QString generateFilter(const QStringList& ext);
+    static QVector<QRect> parseRectList(const QString& text);
 
     static void sendDENotification(QWidget *parent, const QString& text, const QString& title = QString(),
                                    int timeout_ms = 500);
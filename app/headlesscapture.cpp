@@ -0,0 +1,280 @@
+#include <QTimer>
+#include <QPixmap>
+#include <QFileInfo>
+#include <QDebug>
+
+#include <climits>
+#include <cstring>
+
+#include "headlesscapture.h"
+#include "funcs.h"
+
+namespace {
+const int imageQuality = 90;
+const int pngCompression = 6;
+const int maxCompression = 9;
+const int maxQuality = 100;
+const int oneK = 1000;
+const QString fileTemplate = QSL("%NN");
+}
+
+ZHeadlessCapture::ZHeadlessCapture(const ZHeadlessCapture::ZHeadlessOptions &options, QObject *parent)
+    : QObject(parent),
+      m_options(options)
+{
+    // autocapture saves every changed frame at once, as the scan timer did
+    ZCaptureEngine::ZCaptureSettings settings;
+    settings.mode = m_options.mode;
+    settings.region = m_options.region;
+    settings.includePointer = m_options.includePointer;
+    settings.includeDecorations = m_options.includeDecorations;
+    if (m_options.output.isEmpty() || QFileInfo(m_options.output).isDir())
+        settings.outputDir = m_options.output;
+    settings.fileTemplate = m_options.fileTemplate;
+    settings.encoder = m_options.encoder;
+    settings.autocaptureEncoder = m_options.encoder;
+    settings.encoderPolicy = ZEncoderQueue::Block;
+    settings.autocaptureInterval = m_options.autocaptureInterval;
+    settings.autocaptureWait = false;
+    settings.minChangedPixels = m_options.minChangedPixels;
+    settings.minChangedTiles = m_options.minChangedTiles;
+    settings.ignoreRects = m_options.ignoreRects;
+    m_engine.setSettings(settings);
+
+    // called from the encoder pool, the session result must be known at waitForDone
+    connect(&m_engine,&ZCaptureEngine::saveFailed,this,[this](const QString &fileName, const QString &error){
+        qCritical() << QSL("Unable to save file %1: %2").arg(fileName,error);
+        m_failures.ref();
+    },Qt::DirectConnection);
+
+    connect(&m_engine,&ZCaptureEngine::frameCaptured,this,&ZHeadlessCapture::autocaptureFrame);
+    connect(&m_engine,&ZCaptureEngine::autocaptureFailed,this,[this](){
+        qCritical() << "Unable to make autocapture. XCB error, null snapshot received";
+        m_failures.ref();
+        stop();
+    });
+}
+
+ZHeadlessCapture::~ZHeadlessCapture()
+{
+    m_engine.waitForDone();
+}
+
+// The application object type depends on this, so it is checked before
+// QCommandLineParser can be used
+bool ZHeadlessCapture::isHeadlessRequested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "--headless") == 0) || (strcmp(argv[i], "-H") == 0)) // NOLINT
+            return true;
+    }
+    return false;
+}
+
+void ZHeadlessCapture::setupParser(QCommandLineParser *parser)
+{
+    parser->setApplicationDescription(QSL("Screen capture program."));
+    parser->addHelpOption();
+    parser->addOptions({
+        { { QSL("H"), QSL("headless") },
+          QSL("Capture without GUI, using the options below.") },
+        { { QSL("m"), QSL("mode") },
+          QSL("Capture mode: fullscreen, screen, window or region."), QSL("mode") },
+        { { QSL("r"), QSL("region") },
+          QSL("Root window region for region mode."), QSL("x,y,w,h") },
+        { { QSL("f"), QSL("format") },
+          QSL("Image format: %1.").arg(ZGenericFuncs::zImageFormats().join(QSL(", ")).toLower()), QSL("format") },
+        { { QSL("q"), QSL("quality") },
+          QSL("Image quality, 0-100."), QSL("quality") },
+        { { QSL("c"), QSL("compression") },
+          QSL("PNG compression level, 0-9."), QSL("level") },
+        { { QSL("o"), QSL("output") },
+          QSL("Output file, or directory for generated file names."), QSL("path") },
+        { { QSL("t"), QSL("template") },
+          QSL("File name template for generated file names."), QSL("template") },
+        { { QSL("d"), QSL("delay") },
+          QSL("Delay before capture."), QSL("ms") },
+        { { QSL("p"), QSL("pointer") },
+          QSL("Include mouse pointer.") },
+        { QSL("no-decorations"),
+          QSL("Do not include window decorations in window mode.") },
+        { { QSL("a"), QSL("autocapture") },
+          QSL("Start autocapture of the captured area with scan interval."), QSL("ms") },
+        { { QSL("n"), QSL("count") },
+          QSL("Stop autocapture after this number of snapshots."), QSL("count") },
+        { QSL("timeout"),
+          QSL("Stop autocapture after this time."), QSL("seconds") },
+        { QSL("min-pixels"),
+          QSL("Autocapture min changed pixels."), QSL("pixels") },
+        { QSL("min-tiles"),
+          QSL("Autocapture min changed tiles, percent."), QSL("percent") },
+        { QSL("ignore"),
+          QSL("Autocapture ignore areas."), QSL("x,y,w,h;...") },
+        { QSL("service"),
+          QSL("Register D-Bus capture service. With --headless, run the service only, until terminated.") }
+    });
+}
+
+bool ZHeadlessCapture::parseOptions(const QCommandLineParser &parser, ZHeadlessCapture::ZHeadlessOptions *options,
+                                    QString *error)
+{
+    static const QStringList modes = { QSL("fullscreen"), QSL("screen"), QSL("window"), QSL("region") };
+
+    auto intValue = [&parser,error](const QString &name, int defaultValue, int minValue, int maxValue, int *value){
+        *value = defaultValue;
+        if (!parser.isSet(name)) return true;
+
+        bool ok = false;
+        *value = parser.value(name).toInt(&ok);
+        if (!ok || *value < minValue || *value > maxValue) {
+            *error = QSL("Invalid --%1 value: %2").arg(name,parser.value(name));
+            return false;
+        }
+        return true;
+    };
+
+    if (parser.isSet(QSL("region"))) {
+        const QVector<QRect> rects = ZGenericFuncs::parseRectList(parser.value(QSL("region")));
+        if (rects.count() != 1) {
+            *error = QSL("Invalid --region value: %1").arg(parser.value(QSL("region")));
+            return false;
+        }
+        options->region = rects.first();
+        options->mode = ZCaptureEngine::Region;
+    }
+
+    if (parser.isSet(QSL("mode"))) {
+        const int idx = modes.indexOf(parser.value(QSL("mode")).toLower());
+        if (idx < 0) {
+            *error = QSL("Invalid --mode value: %1").arg(parser.value(QSL("mode")));
+            return false;
+        }
+        options->mode = static_cast<ZCaptureEngine::ZCaptureMode>(idx);
+    }
+
+    if (options->mode == ZCaptureEngine::Region && options->region.isEmpty()) {
+        *error = QSL("Region mode requires --region");
+        return false;
+    }
+
+    options->output = parser.value(QSL("output"));
+    options->fileTemplate = parser.isSet(QSL("template")) ? parser.value(QSL("template"))
+                                                          : fileTemplate;
+    options->includePointer = parser.isSet(QSL("pointer"));
+    options->includeDecorations = !parser.isSet(QSL("no-decorations"));
+
+    if (!intValue(QSL("quality"), imageQuality, 0, maxQuality,
+                  &(options->encoder.quality)) ||
+            !intValue(QSL("compression"), pngCompression, 0, maxCompression,
+                      &(options->encoder.compression)) ||
+            !intValue(QSL("delay"), 0, 0, INT_MAX, &(options->delay)) ||
+            !intValue(QSL("autocapture"), 0, 0, INT_MAX, &(options->autocaptureInterval)) ||
+            !intValue(QSL("count"), 0, 0, INT_MAX, &(options->maxSnapshots)) ||
+            !intValue(QSL("timeout"), 0, 0, INT_MAX / oneK, &(options->timeout)) ||
+            !intValue(QSL("min-pixels"), 0, 0, INT_MAX, &(options->minChangedPixels))) {
+        return false;
+    }
+
+    int minTiles = 0;
+    if (!intValue(QSL("min-tiles"), 0, 0, maxQuality, &minTiles))
+        return false;
+    options->minChangedTiles = minTiles / 100.0; // NOLINT
+    options->ignoreRects = ZGenericFuncs::parseRectList(parser.value(QSL("ignore")));
+
+    const bool outputIsDir = options->output.isEmpty() || QFileInfo(options->output).isDir();
+    if (options->autocaptureInterval > 0 && !outputIsDir) {
+        *error = QSL("Autocapture requires --output to be a directory");
+        return false;
+    }
+
+    // explicit format first, then the output file suffix
+    options->encoder.codec = ZImageEncoder::PNG;
+    if (parser.isSet(QSL("format"))) {
+        const int idx = ZGenericFuncs::zImageFormats().indexOf(parser.value(QSL("format")).toUpper());
+        if (idx < 0 || !ZImageEncoder::isSupported(static_cast<ZImageEncoder::ZImageCodec>(idx))) {
+            *error = QSL("Unsupported --format value: %1").arg(parser.value(QSL("format")));
+            return false;
+        }
+        options->encoder.codec = static_cast<ZImageEncoder::ZImageCodec>(idx);
+    } else if (!outputIsDir) {
+        ZImageEncoder::codecForFileName(options->output, &(options->encoder.codec));
+    }
+
+    return true;
+}
+
+void ZHeadlessCapture::start()
+{
+    // the timeout limits autocapture only, a single snapshot always finishes
+    if (m_options.autocaptureInterval > 0 && m_options.timeout > 0)
+        QTimer::singleShot(m_options.timeout * oneK, this, &ZHeadlessCapture::stop);
+
+    QTimer::singleShot(m_options.delay, this, &ZHeadlessCapture::capture);
+}
+
+void ZHeadlessCapture::stop()
+{
+    m_engine.stopAutocapture();
+    m_engine.waitForDone();
+
+    if (m_options.autocaptureInterval > 0)
+        qInfo() << QSL("Autocapture finished, %1 snapshots").arg(m_snapshots);
+
+    finish((m_failures.loadAcquire() > 0) ? 1 : 0);
+}
+
+void ZHeadlessCapture::finish(int exitCode)
+{
+    if (m_finished) return;
+
+    m_finished = true;
+    Q_EMIT finished(exitCode);
+}
+
+QString ZHeadlessCapture::outputFileName(const QSize &size)
+{
+    if (!m_options.output.isEmpty() && !QFileInfo(m_options.output).isDir())
+        return m_options.output;
+
+    return m_engine.nextFileName(size, ZImageEncoder::fileExtension(m_options.encoder.codec));
+}
+
+void ZHeadlessCapture::capture()
+{
+    const QImage image = m_engine.grab(&m_region).toImage();
+    if (image.isNull()) {
+        qCritical() << "Unable to capture. XCB error, null snapshot received";
+        finish(1);
+        return;
+    }
+
+    if (m_options.autocaptureInterval <= 0) {
+        QString error;
+        const QString fileName = outputFileName(image.size());
+        if (!ZImageEncoder::encode(image, fileName, m_options.encoder, &error)) {
+            qCritical() << QSL("Unable to save file %1: %2").arg(fileName,error);
+            finish(1);
+            return;
+        }
+        finish(0);
+        return;
+    }
+
+    // the captured area is watched for changes, as after the interactive snapshot in GUI
+    qInfo() << "Autocapture started, region" << m_region;
+    m_engine.startAutocapture(m_region, true);
+}
+
+// The frame is a capture buffer view, the queue gets its own copy
+// so the buffer memory is reused by the next grab
+void ZHeadlessCapture::autocaptureFrame(const QImage &frame)
+{
+    if (m_finished) return;
+
+    const QImage image = frame.copy();
+    m_engine.saveAsync(image, outputFileName(image.size()), m_options.encoder);
+    m_snapshots++;
+
+    if (m_options.maxSnapshots > 0 && m_snapshots >= m_options.maxSnapshots)
+        stop();
+}
@@ -0,0 +1,71 @@
+#ifndef HEADLESSCAPTURE_H
+#define HEADLESSCAPTURE_H
+
+#include <QObject>
+#include <QImage>
+#include <QRect>
+#include <QString>
+#include <QVector>
+#include <QAtomicInt>
+#include <QCommandLineParser>
+
+#include "captureengine.h"
+#include "imageencoder.h"
+
+// Capture without any widgets, configured from the command line. Makes a single
+// snapshot, or runs autocapture until the snapshot count or the timeout is reached.
+class ZHeadlessCapture : public QObject
+{
+    Q_OBJECT
+public:
+    struct ZHeadlessOptions {
+        ZCaptureEngine::ZCaptureMode mode { ZCaptureEngine::FullScreen };
+        QRect region;
+        ZImageEncoder::ZEncoderOptions encoder;
+        QString output;
+        QString fileTemplate;
+        int delay { 0 };                // ms
+        bool includePointer { false };
+        bool includeDecorations { true };
+        int autocaptureInterval { 0 };  // ms, single snapshot if 0
+        int maxSnapshots { 0 };         // unlimited if 0
+        int timeout { 0 };              // s, unlimited if 0
+        int minChangedPixels { 0 };
+        double minChangedTiles { 0.0 };
+        QVector<QRect> ignoreRects;
+    };
+
+private:
+    Q_DISABLE_COPY(ZHeadlessCapture)
+
+    ZHeadlessOptions m_options;
+    ZCaptureEngine m_engine;
+    QRect m_region;
+    QAtomicInt m_failures;
+    int m_snapshots { 0 };
+    bool m_finished { false };
+
+    QString outputFileName(const QSize &size);
+    void finish(int exitCode);
+
+public:
+    explicit ZHeadlessCapture(const ZHeadlessOptions &options, QObject *parent = nullptr);
+    ~ZHeadlessCapture() override;
+
+    static bool isHeadlessRequested(int argc, char *argv[]);
+    static void setupParser(QCommandLineParser *parser);
+    static bool parseOptions(const QCommandLineParser &parser, ZHeadlessOptions *options, QString *error);
+
+public Q_SLOTS:
+    void start();
+    void stop();
+
+private Q_SLOTS:
+    void capture();
+    void autocaptureFrame(const QImage &frame);
+
+Q_SIGNALS:
+    void finished(int exitCode);
+};
+
+#endif // HEADLESSCAPTURE_H
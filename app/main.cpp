@@ -0,0 +1,74 @@
+#include <QApplication>
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QScopedPointer>
+#include <QPointer>
+#include <QTimer>
+#include <QDebug>
+#include "funcs.h"
+#include "mainwindow.h"
+#include "headlesscapture.h"
+#include "captureservice.h"
+
+QPointer<MainWindow> mainWindow;
+
+int main(int argc, char *argv[])
+{
+    // headless mode does not need widgets, plain GUI application is enough for XCB and pixmaps
+    const bool headless = ZHeadlessCapture::isHeadlessRequested(argc, argv);
+    QScopedPointer<QCoreApplication> a(headless ? new QGuiApplication(argc, argv)
+                                                : new QApplication(argc, argv));
+
+    qSetMessagePattern(QSL("%{if-debug}Debug%{endif}"
+                           "%{if-info}Info%{endif}"
+                           "%{if-warning}Warning%{endif}"
+                           "%{if-critical}Error%{endif}"
+                           "%{if-fatal}Fatal%{endif}"
+                           ": %{message} (%{file}:%{line})"));
+    qInstallMessageHandler(ZGenericFuncs::stdConsoleOutput);
+
+    QCoreApplication::setAttribute(Qt::AA_DontUseNativeDialogs,true);
+    QCoreApplication::setOrganizationName(QSL("kernel1024"));
+    QCoreApplication::setApplicationName(QSL("scrcap"));
+    QGuiApplication::setApplicationDisplayName(QSL("ScrCap"));
+
+    QCommandLineParser parser;
+    ZHeadlessCapture::setupParser(&parser);
+    parser.process(*a);
+
+    if (headless && parser.isSet(QSL("service"))) {
+        ZCaptureService captureService;
+        if (!captureService.registerService())
+            return 1;
+
+        return a->exec();
+    }
+
+    if (headless) {
+        ZHeadlessCapture::ZHeadlessOptions options;
+        QString error;
+        if (!ZHeadlessCapture::parseOptions(parser, &options, &error)) {
+            qCritical() << error;
+            return 1;
+        }
+
+        ZHeadlessCapture capture(options);
+        QObject::connect(&capture,&ZHeadlessCapture::finished,a.data(),&QCoreApplication::exit,Qt::QueuedConnection);
+        QTimer::singleShot(0,&capture,&ZHeadlessCapture::start);
+
+        return a->exec();
+    }
+
+    // the GUI serves D-Bus captures only when asked to
+    QScopedPointer<ZCaptureService> captureService;
+    if (parser.isSet(QSL("service")) || MainWindow::isCaptureServiceEnabled()) {
+        captureService.reset(new ZCaptureService());
+        captureService->registerService();
+    }
+
+    MainWindow w;
+    mainWindow = &w;
+    w.show();
+    
+    return a->exec();
+}
@@ -0,0 +1,877 @@
+/*
+ *  Portions from KSnapshot (KDE), KScreengenie (KF5)
+ *
+ *  Copyright (C) 1997-2008 Richard J. Moore <rich@kde.org>
+ *  Copyright (C) 2000 Matthias Ettrich <ettrich@troll.no>
+ *  Copyright (C) 2002 Aaron J. Seigo <aseigo@kde.org>
+ *  Copyright (C) 2003 Nadeem Hasan <nhasan@kde.org>
+ *  Copyright (C) 2004 Bernd Brandstetter <bbrand@freenet.de>
+ *  Copyright (C) 2006 Urs Wolfer <uwolfer @ kde.org>
+ *  Copyright (C) 2010 Martin Gräßlin <kde@martin-graesslin.com>
+ *  Copyright (C) 2010, 2011 Pau Garcia i Quiles <pgquiles@elpauer.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include <QApplication>
+#include <QScreen>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QImage>
+#include <QPainter>
+#include <QScreen>
+#include <QWindow>
+#include <QMessageBox>
+#include <QClipboard>
+#include <QFileInfo>
+#include <QDebug>
+
+#include "mainwindow.h"
+#include "funcs.h"
+#include "windowgrabber.h"
+#include "regiongrabber.h"
+#include "xcbtools.h"
+#include "qxtglobalshortcut.h"
+#include "ui_mainwindow.h"
+
+namespace CDefaults {
+const ZCaptureEngine::ZCaptureMode captureMode = ZCaptureEngine::FullScreen;
+const int autocaptureDelay = 1000;
+const int imageQuality = 90;
+const int pngCompression = 6;
+const ZImageEncoder::ZImageCodec autocaptureFormat = ZImageEncoder::PNG;
+const int autocapturePngCompression = 1;
+const int encoderQueueDepth = 8;
+const ZEncoderQueue::ZOverflowPolicy encoderPolicy = ZEncoderQueue::Block;
+const int captureErrorTimerMS = 1000;
+const int interactiveCaptureTimerMS = 200;
+const bool includeDeco = true;
+const bool includePointer = false;
+const bool autocaptureWait = true;
+const bool autocaptureDamage = true;
+const bool autocaptureStable = false;
+const bool autocaptureAnimation = false;
+const int autocaptureMaxSettleIntervals = 10;
+const bool minimizeWindow = false;
+const bool captureService = false;
+const int recordFrameRate = 15;
+const ZGSTRecorder::ZRecordFormat recordFormat = ZGSTRecorder::MP4;
+const QSize previewSize(500,300);
+}
+
+MainWindow::MainWindow(QWidget *parent) :
+    QMainWindow(parent),
+    ui(new Ui::MainWindow)
+{
+    ui->setupUi(this);
+
+    ui->listMode->addItems(ZGenericFuncs::zCaptureMode());
+
+    ui->listImgFormat->addItems(ZGenericFuncs::zImageFormats());
+    ui->listAutocaptureFormat->addItems(ZGenericFuncs::zImageFormats());
+    if (!ZImageEncoder::isSupported(ZImageEncoder::WebP)) {
+        ui->listImgFormat->removeItem(ZImageEncoder::WebP);
+        ui->listAutocaptureFormat->removeItem(ZImageEncoder::WebP);
+    }
+    ui->listImgFormat->setCurrentIndex(0);
+
+    ui->listEncoderPolicy->addItems(ZGenericFuncs::zEncoderPolicies());
+    ui->listRecordFormat->addItems(ZGenericFuncs::zRecordFormats());
+    ui->listAnimationFormat->addItems(ZGenericFuncs::zAnimationFormats());
+    if (!ZAnimationWriter::isWebPSupported())
+        ui->listAnimationFormat->removeItem(ZAnimationWriter::WebP);
+
+    ui->spinCounter->setMaximum(INT_MAX);
+
+    ui->btnSndPlay->setEnabled(beepPlayer.isGSTSupported());
+    if (!ui->btnSndPlay->isEnabled())
+        ui->btnSndPlay->setToolTip(tr("GStreamer support disabled."));
+    ui->btnRecord->setEnabled(recorder.isGSTSupported());
+    if (!ui->btnRecord->isEnabled())
+        ui->btnRecord->setToolTip(tr("GStreamer support disabled."));
+
+    recordTimer.setSingleShot(false);
+
+    connect(ui->editLog, &QTextEdit::textChanged,this,[this](){
+        ui->linesCount->setText(tr("%1 messages").arg(ui->editLog->document()->lineCount() - 1));
+    });
+
+    connect(ui->spinEncoderQueue, qOverload<int>(&QSpinBox::valueChanged), this, [this](){
+        engine.setSettings(captureSettings());
+    });
+    connect(ui->listEncoderPolicy, qOverload<int>(&QComboBox::currentIndexChanged), this, [this](){
+        engine.setSettings(captureSettings());
+    });
+    connect(ui->editDir, &QLineEdit::textChanged, this, [this](){
+        engine.setSettings(captureSettings());
+    });
+    connect(ui->editTemplate, &QLineEdit::textChanged, this, [this](){
+        engine.setSettings(captureSettings());
+    });
+    connect(ui->spinCounter, qOverload<int>(&QSpinBox::valueChanged), &engine, &ZCaptureEngine::setCounter);
+    connect(&engine, &ZCaptureEngine::saved, this, &MainWindow::snapshotSaved);
+    connect(&engine, &ZCaptureEngine::saveFailed, this, &MainWindow::snapshotSaveFailed);
+    connect(&engine, &ZCaptureEngine::dropped, this, &MainWindow::snapshotDropped);
+    connect(&engine, &ZCaptureEngine::frameCaptured, this, &MainWindow::autocaptureFrame);
+    connect(&engine, &ZCaptureEngine::autocaptureFailed, this, &MainWindow::autocaptureFailed);
+
+    connect(&recorder, &ZGSTRecorder::started, this, [](const QString& fileName){
+        qInfo() << QSL("Recording started: %1").arg(fileName);
+    });
+    connect(&recorder, &ZGSTRecorder::stopped, this, [](const QString& fileName, quint64 frames, quint64 dropped){
+        qInfo() << QSL("Recording finished: %1, %2 frames, %3 dropped").arg(fileName).arg(frames).arg(dropped);
+    });
+    connect(&recorder, &ZGSTRecorder::error, this, [this](const QString& message){
+        qWarning() << message;
+        ui->btnRecord->setChecked(false);
+    });
+
+    loadSettings();
+    centerWindow();
+    engine.setSettings(captureSettings());
+    engine.setCounter(ui->spinCounter->value());
+
+    connect(ui->btnCapture, &QPushButton::clicked, this, &MainWindow::actionCapture);
+    connect(ui->btnSave, &QPushButton::clicked, this, &MainWindow::saveAs);
+    connect(ui->btnCopy, &QPushButton::clicked, this, &MainWindow::copyToClipboard);
+    connect(ui->btnAutocapture, &QPushButton::toggled, this, &MainWindow::actionAutoCapture);
+    connect(ui->btnRecord, &QPushButton::toggled, this, &MainWindow::actionRecord);
+    connect(ui->btnDir, &QPushButton::clicked, this, &MainWindow::saveDirSelect);
+    connect(ui->btnAutoSnd, &QPushButton::clicked, this, &MainWindow::autocaptureSndSelect);
+    connect(ui->btnSndPlay, &QPushButton::clicked, this, &MainWindow::playSample);
+    connect(ui->btnClearLog, &QPushButton::clicked, this, &MainWindow::clearLog);
+
+    connect(ui->keyInteractive, &QKeySequenceEdit::editingFinished, this, &MainWindow::rebindHotkeys);
+    connect(ui->keySilent, &QKeySequenceEdit::editingFinished, this, &MainWindow::rebindHotkeys);
+
+    connect(&recordTimer, &QTimer::timeout, this, &MainWindow::recordFrame);
+
+    doCapture(PreInit);
+}
+
+MainWindow::~MainWindow()
+{
+    delete ui;
+}
+
+int MainWindow::capMode()
+{
+    return ui->listMode->currentIndex();
+}
+
+// Read before the window is created, the service lets any session client grab the screen
+bool MainWindow::isCaptureServiceEnabled()
+{
+    QSettings settings;
+    settings.beginGroup(QSL("global"));
+    return settings.value(QSL("captureService"),CDefaults::captureService).toBool();
+}
+
+void MainWindow::centerWindow()
+{
+    QScreen *screen = nullptr;
+
+    if (window() && window()->windowHandle()) {
+        screen = window()->windowHandle()->screen();
+    } else if (!QApplication::screens().isEmpty()) {
+        screen = QApplication::screenAt(QCursor::pos());
+    }
+    if (screen == nullptr)
+        screen = QApplication::primaryScreen();
+
+    QRect rect(screen->availableGeometry());
+    move(rect.width()/2 - frameGeometry().width()/2,
+         rect.height()/2 - frameGeometry().height()/2);
+}
+
+void MainWindow::loadSettings()
+{
+    QSettings settings;
+    settings.beginGroup(QSL("global"));
+    ui->listMode->setCurrentIndex(settings.value(QSL("mode"),CDefaults::captureMode).toInt());
+    ui->spinDelay->setValue(settings.value(QSL("delay"),0).toInt());
+    ui->spinAutocapInterval->setValue(settings.value(QSL("autocapDelay"),CDefaults::autocaptureDelay).toInt());
+
+    QString s = settings.value(QSL("keyInteractive"),QString()).toString();
+    if (!s.isEmpty()) {
+        ui->keyInteractive->setKeySequence(QKeySequence::fromString(s));
+    } else {
+        ui->keyInteractive->clear();
+    }
+    s = settings.value(QSL("keySilent"),QString()).toString();
+    if (!s.isEmpty()) {
+        ui->keySilent->setKeySequence(QKeySequence::fromString(s));
+    } else {
+        ui->keySilent->clear();
+    }
+
+    ui->spinAutocapMinPixels->setValue(settings.value(QSL("autocapMinPixels"),0).toInt());
+    ui->spinAutocapMinTiles->setValue(settings.value(QSL("autocapMinTiles"),0.0).toDouble());
+    ui->editAutocapIgnore->setText(settings.value(QSL("autocapIgnore"),QString()).toString());
+
+    ui->checkIncludeDeco->setChecked(settings.value(QSL("includeDeco"),CDefaults::includeDeco).toBool());
+    ui->checkIncludePointer->setChecked(settings.value(QSL("includePointer"),CDefaults::includePointer).toBool());
+    ui->checkAutocaptureWait->setChecked(settings.value(QSL("autocaptureWait"),CDefaults::autocaptureWait).toBool());
+    ui->checkAutocaptureDamage->setChecked(settings.value(QSL("autocaptureDamage"),CDefaults::autocaptureDamage).toBool());
+    ui->checkAutocaptureStable->setChecked(settings.value(QSL("autocaptureStable"),CDefaults::autocaptureStable).toBool());
+    ui->checkAutocaptureAnimation->setChecked(settings.value(QSL("autocaptureAnimation"),CDefaults::autocaptureAnimation).toBool());
+    ui->checkMinimize->setChecked(settings.value(QSL("minimizeWindow"),CDefaults::minimizeWindow).toBool());
+    ui->checkCaptureService->setChecked(settings.value(QSL("captureService"),CDefaults::captureService).toBool());
+
+    s = settings.value(QSL("imageFormat"),ZGenericFuncs::zImageFormats().first()).toString();
+    int idx = ui->listImgFormat->findText(s);
+    if (idx>=0) {
+        ui->listImgFormat->setCurrentIndex(idx);
+    } else {
+        ui->listImgFormat->setCurrentIndex(0);
+    }
+    s = settings.value(QSL("autocaptureFormat"),
+                       ZGenericFuncs::zImageFormats().at(CDefaults::autocaptureFormat)).toString();
+    idx = ui->listAutocaptureFormat->findText(s);
+    if (idx>=0) {
+        ui->listAutocaptureFormat->setCurrentIndex(idx);
+    } else {
+        ui->listAutocaptureFormat->setCurrentIndex(0);
+    }
+    ui->spinImgQuality->setValue(settings.value(QSL("imageQuality"),CDefaults::imageQuality).toInt());
+    ui->spinPngCompression->setValue(settings.value(QSL("pngCompression"),CDefaults::pngCompression).toInt());
+    ui->spinAutocapturePngCompression->setValue(settings.value(QSL("autocapturePngCompression"),
+                                                               CDefaults::autocapturePngCompression).toInt());
+    ui->spinEncoderQueue->setValue(settings.value(QSL("encoderQueueDepth"),CDefaults::encoderQueueDepth).toInt());
+    ui->listEncoderPolicy->setCurrentIndex(settings.value(QSL("encoderPolicy"),CDefaults::encoderPolicy).toInt());
+    ui->listRecordFormat->setCurrentIndex(settings.value(QSL("recordFormat"),CDefaults::recordFormat).toInt());
+    ui->spinRecordFrameRate->setValue(settings.value(QSL("recordFrameRate"),CDefaults::recordFrameRate).toInt());
+    idx = settings.value(QSL("animationFormat"),ZAnimationWriter::APNG).toInt();
+    if (idx < ui->listAnimationFormat->count())
+        ui->listAnimationFormat->setCurrentIndex(idx);
+
+    ui->editDir->setText(settings.value(QSL("saveDir"),
+                                        QStandardPaths::writableLocation(QStandardPaths::HomeLocation))
+                         .toString());
+    ui->editTemplate->setText(settings.value(QSL("filenameTemplate"),QSL("%NN")).toString());
+    ui->editAutoSnd->setText(settings.value(QSL("autocaptureSound"),QString()).toString());
+    settings.endGroup();
+
+    rebindHotkeys();
+}
+
+void MainWindow::saveSettings()
+{
+    QSettings settings;
+    settings.beginGroup(QSL("global"));
+    settings.setValue(QSL("mode"),capMode());
+    settings.setValue(QSL("delay"),ui->spinDelay->value());
+    settings.setValue(QSL("autocapDelay"),ui->spinAutocapInterval->value());
+
+    settings.setValue(QSL("autocapMinPixels"),ui->spinAutocapMinPixels->value());
+    settings.setValue(QSL("autocapMinTiles"),ui->spinAutocapMinTiles->value());
+    settings.setValue(QSL("autocapIgnore"),ui->editAutocapIgnore->text());
+
+    settings.setValue(QSL("keyInteractive"),ui->keyInteractive->keySequence().toString());
+    settings.setValue(QSL("keySilent"),ui->keySilent->keySequence().toString());
+
+    settings.setValue(QSL("includeDeco"),ui->checkIncludeDeco->isChecked());
+    settings.setValue(QSL("includePointer"),ui->checkIncludePointer->isChecked());
+    settings.setValue(QSL("autocaptureWait"),ui->checkAutocaptureWait->isChecked());
+    settings.setValue(QSL("autocaptureDamage"),ui->checkAutocaptureDamage->isChecked());
+    settings.setValue(QSL("autocaptureStable"),ui->checkAutocaptureStable->isChecked());
+    settings.setValue(QSL("autocaptureAnimation"),ui->checkAutocaptureAnimation->isChecked());
+    settings.setValue(QSL("minimizeWindow"),ui->checkMinimize->isChecked());
+    settings.setValue(QSL("captureService"),ui->checkCaptureService->isChecked());
+
+    settings.setValue(QSL("imageFormat"),ui->listImgFormat->currentText());
+    settings.setValue(QSL("imageQuality"),ui->spinImgQuality->value());
+    settings.setValue(QSL("pngCompression"),ui->spinPngCompression->value());
+    settings.setValue(QSL("autocaptureFormat"),ui->listAutocaptureFormat->currentText());
+    settings.setValue(QSL("autocapturePngCompression"),ui->spinAutocapturePngCompression->value());
+    settings.setValue(QSL("encoderQueueDepth"),ui->spinEncoderQueue->value());
+    settings.setValue(QSL("encoderPolicy"),ui->listEncoderPolicy->currentIndex());
+    settings.setValue(QSL("recordFormat"),ui->listRecordFormat->currentIndex());
+    settings.setValue(QSL("recordFrameRate"),ui->spinRecordFrameRate->value());
+    settings.setValue(QSL("animationFormat"),ui->listAnimationFormat->currentIndex());
+
+    settings.setValue(QSL("saveDir"),ui->editDir->text());
+    settings.setValue(QSL("filenameTemplate"),ui->editTemplate->text());
+    settings.setValue(QSL("autocaptureSound"),ui->editAutoSnd->text());
+    settings.endGroup();
+}
+
+void MainWindow::closeEvent(QCloseEvent *event)
+{
+    if (!saved) {
+        int ret = QMessageBox::warning(this,QGuiApplication::applicationDisplayName(),
+                                       tr("The screenshot has been modified. Do you want to save?"),
+                                       QMessageBox::Save | QMessageBox::Discard | QMessageBox::Cancel,
+                                       QMessageBox::Save);
+        if (ret == QMessageBox::Save) {
+            if (!saveAs()) {
+                event->ignore();
+                return;
+            }
+        } else if (ret == QMessageBox::Cancel) {
+            event->ignore();
+            return;
+        }
+    }
+
+    saveSettings();
+    if (ui->btnRecord->isChecked())
+        ui->btnRecord->setChecked(false);
+    engine.waitForDone();
+    keyInteractive->setDisabled();
+    keySilent->setDisabled();
+    event->accept();
+}
+
+void MainWindow::updatePreview()
+{
+    QPixmap px = snapshot.scaled(CDefaults::previewSize,Qt::KeepAspectRatio,Qt::SmoothTransformation);
+    ui->imageDisplay->setPixmap(px);
+
+    QString title = tr("Screen capture");
+    if (!saved)
+        title.append(tr(" (* unsaved)"));
+    setWindowTitle(title);
+}
+
+void MainWindow::hotkeyInteractive()
+{
+    if (ui->btnAutocapture->isChecked())
+        ui->btnAutocapture->setChecked(false);
+    if (ui->btnRecord->isChecked())
+        ui->btnRecord->setChecked(false);
+
+    if (isVisible()) {
+        actionCapture();
+        return;
+    }
+
+    restoreWindow();
+}
+
+void MainWindow::actionCapture()
+{
+    const int oneK = 1000;
+
+    hideWindow();
+
+    int captureDelayMS = ui->spinDelay->value() * oneK;
+    if (captureDelayMS < CDefaults::interactiveCaptureTimerMS)
+        captureDelayMS = CDefaults::interactiveCaptureTimerMS;
+
+    QTimer::singleShot(captureDelayMS,this,&MainWindow::interactiveCapture);
+}
+
+void MainWindow::actionAutoCapture(bool state)
+{
+    if (state) {
+        if (lastRegion.isEmpty()) {
+            QMessageBox::warning(this,QGuiApplication::applicationDisplayName(),
+                                 tr("Unable to start autocapture.\n"
+                                    "You must make interactive snapshot first "
+                                    "to mark out area for silent/automatic snapshots."));
+            return;
+        }
+
+        if (ui->btnRecord->isChecked())
+            ui->btnRecord->setChecked(false);
+
+        if (ui->checkAutocaptureAnimation->isChecked() && !startAnimation()) {
+            ui->btnAutocapture->setChecked(false);
+            return;
+        }
+
+        engine.setSettings(captureSettings());
+
+        hideWindow();
+
+        engine.startAutocapture(lastRegion);
+    } else {
+        engine.stopAutocapture();
+        finishAnimation();
+    }
+}
+
+bool MainWindow::startAnimation()
+{
+    const auto format = static_cast<ZAnimationWriter::ZAnimationFormat>(ui->listAnimationFormat->currentIndex());
+    const QString fname = nextFileName(ZAnimationWriter::fileExtension(format));
+
+    if (!animationWriter.start(fname, format, ui->spinImgQuality->value(), ui->spinPngCompression->value())) {
+        QMessageBox::warning(this,QGuiApplication::applicationDisplayName(),
+                             tr("Unable to start autocapture.\n%1").arg(animationWriter.errorString()));
+        return false;
+    }
+
+    animationTime.start();
+    qInfo() << QSL("Autocapture animation started: %1").arg(fname);
+    return true;
+}
+
+void MainWindow::finishAnimation()
+{
+    if (!animationWriter.isActive()) return;
+
+    if (animationWriter.finish()) {
+        qInfo() << QSL("Autocapture animation saved, %1 frames").arg(animationWriter.framesCount());
+    } else {
+        qWarning() << QSL("Autocapture animation was not saved: %1").arg(animationWriter.errorString());
+    }
+}
+
+void MainWindow::actionRecord(bool state)
+{
+    const int oneK = 1000;
+
+    if (state) {
+        if (lastRegion.isEmpty()) {
+            ui->btnRecord->setChecked(false);
+            QMessageBox::warning(this,QGuiApplication::applicationDisplayName(),
+                                 tr("Unable to start recording.\n"
+                                    "You must make interactive snapshot first "
+                                    "to mark out area for silent/automatic snapshots."));
+            return;
+        }
+
+        if (ui->btnAutocapture->isChecked())
+            ui->btnAutocapture->setChecked(false);
+
+        const auto format = static_cast<ZGSTRecorder::ZRecordFormat>(ui->listRecordFormat->currentIndex());
+        const QString fname = nextFileName(ZGSTRecorder::fileExtension(format));
+        if (!recorder.start(fname, format, ui->spinRecordFrameRate->value())) {
+            ui->btnRecord->setChecked(false);
+            return;
+        }
+
+        hideWindow();
+        recordTimer.start(oneK / ui->spinRecordFrameRate->value());
+    } else {
+        if (recordTimer.isActive())
+            recordTimer.stop();
+        recorder.stop();
+    }
+}
+
+void MainWindow::recordFrame()
+{
+    // a tick coming while the previous frame is still transferred is skipped,
+    // the recorder timestamps the frames as they are pushed
+    if (!recorder.isRecording() || recordGrabbing) return;
+
+    const QRect region = lastRegion;
+    recordGrabbing = true;
+    ZXCBTools::requestRootImage(region,this,[this,region](QImage frame){
+        recordGrabbing = false;
+        if (!recorder.isRecording()) return;
+
+        if (frame.isNull()) {
+            ui->btnRecord->setChecked(false);
+            QTimer::singleShot(CDefaults::captureErrorTimerMS,this,[this](){
+                QMessageBox::critical(this,QGuiApplication::applicationDisplayName(),
+                                      tr("Unable to record video. XCB error, null frame received"));
+            });
+            return;
+        }
+
+        // the pointer is painted into the capture buffer in place
+        if (ui->checkIncludePointer->isChecked())
+            ZXCBTools::blendCursorImage(frame, qMax(region.x(), 0), qMax(region.y(), 0));
+
+        // the single copy out of the reused capture buffer is handed to the encoder as is,
+        // even dimensions are required by most of the video encoders
+        recorder.pushFrame(frame.copy(0, 0, frame.width() & ~1, frame.height() & ~1));
+    });
+}
+
+void MainWindow::interactiveCapture()
+{
+    doCapture(UserSingle);
+}
+
+void MainWindow::silentCaptureAndSave()
+{
+    hideWindow();
+
+    doCapture(SilentHotkey);
+}
+
+// The frame is a view into the capture buffer, the pixmap makes the copy
+void MainWindow::autocaptureFrame(const QImage &frame)
+{
+    snapshot = QPixmap::fromImage(frame);
+    updatePreview();
+    saveAutocaptureSnapshot();
+}
+
+void MainWindow::autocaptureFailed(const QString &message)
+{
+    ui->btnAutocapture->setChecked(false);
+    QTimer::singleShot(CDefaults::captureErrorTimerMS,this,[this,message](){
+        QMessageBox::critical(this,QGuiApplication::applicationDisplayName(),message);
+    });
+}
+
+void MainWindow::saveAutocaptureSnapshot()
+{
+    if (snapshot.isNull()) return;
+
+    // all the changed frames of the session go into a single animation file
+    if (animationWriter.isActive()) {
+        if (animationWriter.addFrame(snapshot.toImage(), static_cast<int>(animationTime.elapsed())))
+            playSound(ui->editAutoSnd->text());
+        return;
+    }
+
+    const ZImageEncoder::ZEncoderOptions options = encoderOptions(true);
+    const QString fname = nextFileName(ZImageEncoder::fileExtension(options.codec));
+    if (saveSnapshotAsync(fname,options,false))
+        playSound(ui->editAutoSnd->text());
+}
+
+// File names are numbered by the engine, the counter spin box follows it
+// and a value typed there continues the numbering
+QString MainWindow::nextFileName(const QString &extension)
+{
+    const QString res = engine.nextFileName(snapshot.size(), extension);
+    ui->spinCounter->setValue(engine.counter());
+    return res;
+}
+
+void MainWindow::doCapture(const ZCaptureReason reason)
+{
+    int mode = capMode();
+    bool includePointer = ui->checkIncludePointer->isChecked();
+    bool includeDecorations = ui->checkIncludeDeco->isChecked();
+
+    if (reason==SilentHotkey) {
+        if (!lastRegion.isEmpty()) {
+            ZCaptureEngine::requestGrab(ZCaptureEngine::Region, lastRegion, includePointer, includeDecorations,
+                                        this, [this](const QPixmap &pic, const QRect &){
+                snapshot = pic;
+                if (snapshot.isNull()) {
+                    QMessageBox::critical(nullptr,QGuiApplication::applicationDisplayName(),
+                                          tr("Unable to make silent capture. XCB error, null snapshot received"));
+                }
+                updatePreview();
+                if (snapshot.isNull()) return;
+
+                const ZImageEncoder::ZEncoderOptions options = encoderOptions(false);
+                const QString fname = nextFileName(ZImageEncoder::fileExtension(options.codec));
+                saveSnapshotAsync(fname,options,true);
+            });
+        } else {
+            show();
+            QMessageBox::warning(this,QGuiApplication::applicationDisplayName(),
+                                 tr("Unable to make silent capture.\n"
+                                    "You must make interactive snapshot first "
+                                    "to mark out area for silent/automatic snapshots."));
+        }
+        return;
+    }
+
+    if (reason==PreInit && (mode==ChildWindow || mode==ZCaptureEngine::Region))
+        mode = ZCaptureEngine::WindowUnderCursor;
+
+    if (mode==ZCaptureEngine::FullScreen || mode==ZCaptureEngine::CurrentScreen ||
+            mode==ZCaptureEngine::WindowUnderCursor) {
+
+        ZCaptureEngine::requestGrab(static_cast<ZCaptureEngine::ZCaptureMode>(mode), QRect(), includePointer,
+                                    includeDecorations, this, [this,reason](const QPixmap &pic, const QRect &region){
+            snapshot = pic;
+            if (!region.isNull())
+                lastRegion = region;
+
+            if (reason==UserSingle)
+                saved = false;
+
+            updatePreview();
+            restoreWindow();
+        });
+
+    } else if (mode==ChildWindow) {
+
+        WindowGrabber wndGrab(nullptr,includeDecorations,includePointer);
+        connect(&wndGrab, &WindowGrabber::windowGrabbed,
+                this, &MainWindow::windowGrabbed);
+        wndGrab.exec();
+
+    } else if (mode==ZCaptureEngine::Region) {
+
+        auto* rgnGrab = new RegionGrabber(nullptr,lastGrabbedRegion,includePointer);
+        connect(rgnGrab, &RegionGrabber::regionGrabbed,
+                this, &MainWindow::regionGrabbed);
+
+    }
+}
+
+bool MainWindow::saveSnapshot(const QString &filename)
+{
+    // the codec follows the file name chosen in the save dialog
+    bool res = false;
+    ZImageEncoder::ZEncoderOptions options = encoderOptions(false);
+    if (ZImageEncoder::codecForFileName(filename,&options.codec)) {
+        res = ZImageEncoder::encode(snapshot.toImage(),filename,options);
+    } else {
+        res = snapshot.save(filename,nullptr,ui->spinImgQuality->value());
+    }
+
+    if (!res) {
+        QMessageBox::critical(this,QGuiApplication::applicationDisplayName(),
+                              tr("Unable to save file %1").arg(filename));
+        return false;
+    }
+    saved = true;
+    updatePreview();
+    return true;
+}
+
+bool MainWindow::saveSnapshotAsync(const QString &filename, const ZImageEncoder::ZEncoderOptions &options,
+                                   bool notify)
+{
+    if (notify)
+        pendingNotifications.insert(filename);
+    lastQueuedFile = filename;
+
+    return engine.saveAsync(snapshot.toImage(),filename,options);
+}
+
+// Autocapture has its own codec and PNG compression level, tuned for high capture rates
+ZImageEncoder::ZEncoderOptions MainWindow::encoderOptions(bool autocapture) const
+{
+    ZImageEncoder::ZEncoderOptions res;
+    int idx = -1;
+    res.quality = ui->spinImgQuality->value();
+    if (autocapture) {
+        idx = ZGenericFuncs::zImageFormats().indexOf(ui->listAutocaptureFormat->currentText());
+        res.compression = ui->spinAutocapturePngCompression->value();
+    } else {
+        idx = ZGenericFuncs::zImageFormats().indexOf(ui->listImgFormat->currentText());
+        res.compression = ui->spinPngCompression->value();
+    }
+    if (idx >= 0)
+        res.codec = static_cast<ZImageEncoder::ZImageCodec>(idx);
+
+    return res;
+}
+
+ZCaptureEngine::ZCaptureSettings MainWindow::captureSettings() const
+{
+    ZCaptureEngine::ZCaptureSettings res;
+    res.mode = ZCaptureEngine::Region;
+    res.region = lastRegion;
+    res.includePointer = ui->checkIncludePointer->isChecked();
+    res.includeDecorations = ui->checkIncludeDeco->isChecked();
+    res.outputDir = ui->editDir->text();
+    res.fileTemplate = ui->editTemplate->text();
+    res.encoder = encoderOptions(false);
+    res.autocaptureEncoder = encoderOptions(true);
+    res.encoderQueueDepth = ui->spinEncoderQueue->value();
+    res.encoderPolicy = static_cast<ZEncoderQueue::ZOverflowPolicy>(qMax(0,ui->listEncoderPolicy->currentIndex()));
+    res.autocaptureInterval = ui->spinAutocapInterval->value();
+    res.autocaptureMaxSettleIntervals = CDefaults::autocaptureMaxSettleIntervals;
+    res.autocaptureWait = ui->checkAutocaptureWait->isChecked();
+    res.autocaptureStable = ui->checkAutocaptureStable->isChecked();
+    res.autocaptureDamage = ui->checkAutocaptureDamage->isChecked();
+    res.minChangedPixels = ui->spinAutocapMinPixels->value();
+    res.minChangedTiles = ui->spinAutocapMinTiles->value() / 100.0;
+    res.ignoreRects = ZGenericFuncs::parseRectList(ui->editAutocapIgnore->text());
+    return res;
+}
+
+void MainWindow::snapshotSaved(const QString &filename)
+{
+    if (filename == lastQueuedFile) {
+        saved = true;
+        updatePreview();
+    }
+
+    if (pendingNotifications.remove(filename)) {
+        QFileInfo fi(filename);
+        ZGenericFuncs::sendDENotification(this,tr("Screenshot saved - %1").arg(fi.fileName()),
+                                          QGuiApplication::applicationDisplayName(),ui->spinAutocapInterval->value());
+    }
+}
+
+void MainWindow::snapshotSaveFailed(const QString &filename, const QString &error)
+{
+    pendingNotifications.remove(filename);
+
+    if (ui->btnAutocapture->isChecked())
+        ui->btnAutocapture->setChecked(false);
+
+    QMessageBox::critical(this,QGuiApplication::applicationDisplayName(),
+                          tr("Unable to save file %1.\n%2").arg(filename,error));
+}
+
+void MainWindow::snapshotDropped(const QString &filename)
+{
+    pendingNotifications.remove(filename);
+    qWarning() << "Save queue is full, snapshot dropped:" << filename;
+}
+
+void MainWindow::playSound(const QString &filename)
+{
+    QUrl uri = QUrl::fromLocalFile(filename);
+    if (!uri.isValid()) return;
+
+    if (beepPlayer.media() != uri)
+        beepPlayer.setMedia(uri);
+
+    beepPlayer.play();
+}
+
+void MainWindow::hideWindow()
+{
+    if (ui->checkMinimize->isChecked()) {
+        if (!isMinimized())
+            showMinimized();
+    } else {
+        if (isVisible())
+            hide();
+    }
+    QApplication::processEvents();
+}
+
+bool MainWindow::saveAs()
+{
+    if (snapshot.isNull()) return false;
+
+    QStringList formats;
+    formats.reserve(ui->listImgFormat->count());
+    for (int i=0;i<ui->listImgFormat->count();i++)
+        formats.append(ui->listImgFormat->itemText(i));
+
+    if (saveDialogFilter.isEmpty())
+        saveDialogFilter = ZGenericFuncs::generateFilter({ ui->listImgFormat->currentText() });
+    const QString uniq = QFileInfo(nextFileName(QString())).fileName();
+    const QString fname = ZGenericFuncs::getSaveFileNameD(this,tr("Save screenshot"),ui->editDir->text(),
+                                                          ZGenericFuncs::generateFilter(formats),
+                                                          &saveDialogFilter,
+                                                          QFileDialog::DontUseNativeDialog |
+                                                          QFileDialog::DontUseCustomDirectoryIcons,
+                                                          uniq);
+
+    if (fname.isNull() || fname.isEmpty()) return false;
+
+    if (!saveSnapshot(fname)) {
+        QMessageBox::warning(this,QGuiApplication::applicationDisplayName(),tr("File not saved."));
+        return false;
+    }
+    return true;
+}
+
+void MainWindow::playSample()
+{
+    playSound(ui->editAutoSnd->text());
+}
+
+void MainWindow::saveDirSelect()
+{
+    const QString s = ZGenericFuncs::getExistingDirectoryD(this,tr("Directory for screenshots"),ui->editDir->text());
+    if (!s.isEmpty())
+        ui->editDir->setText(s);
+}
+
+void MainWindow::autocaptureSndSelect()
+{
+    const QString fname = ZGenericFuncs::getOpenFileNameD(this,tr("Sound file for autocapture event"),QString(),
+                                                          tr("Audio files (*.mp3 *.wav *.ogg *.flac)"));
+    if (!fname.isEmpty())
+        ui->editAutoSnd->setText(fname);
+}
+
+void MainWindow::copyToClipboard()
+{
+    if (snapshot.isNull()) return;
+    QApplication::clipboard()->setPixmap(snapshot);
+}
+
+void MainWindow::windowGrabbed(const QPixmap &pic, const QRect &region)
+{
+    snapshot = pic;
+    saved = false;
+    updatePreview();
+
+    lastRegion = region;
+
+    QApplication::restoreOverrideCursor();
+    restoreWindow();
+}
+
+void MainWindow::regionGrabbed(const QPixmap &pic, const QRect& region)
+{
+    if (!pic.isNull()) {
+        snapshot = pic;
+        saved = false;
+        updatePreview();
+    }
+
+    lastGrabbedRegion = region;
+    lastRegion = region;
+
+    auto* rgnGrab = qobject_cast<RegionGrabber *>(sender());
+    if (capMode() == ZCaptureEngine::Region && rgnGrab)
+        rgnGrab->deleteLater();
+
+
+    QApplication::restoreOverrideCursor();
+    restoreWindow();
+}
+
+void MainWindow::rebindHotkeys()
+{
+    if (!ui->keyInteractive->keySequence().isEmpty()) {
+        if (keyInteractive)
+            keyInteractive->deleteLater();
+        keyInteractive = new QxtGlobalShortcut(ui->keyInteractive->keySequence(),this);
+        connect(keyInteractive, &QxtGlobalShortcut::activated, this, &MainWindow::hotkeyInteractive);
+        keyInteractive->setEnabled();
+    } else {
+        if (keyInteractive)
+            keyInteractive->setDisabled();
+    }
+
+    if (!ui->keySilent->keySequence().isEmpty()) {
+        if (keySilent)
+            keySilent->deleteLater();
+        keySilent = new QxtGlobalShortcut(ui->keySilent->keySequence(),this);
+        connect(keySilent, &QxtGlobalShortcut::activated, this, &MainWindow::silentCaptureAndSave);
+        keySilent->setEnabled();
+    } else {
+        if (keySilent)
+            keySilent->setDisabled();
+    }
+}
+
+void MainWindow::restoreWindow()
+{
+    showNormal();
+    raise();
+    activateWindow();
+}
+
+void MainWindow::addLogMessage(const QString &message)
+{
+    ui->editLog->moveCursor(QTextCursor::End);
+    ui->editLog->insertPlainText(message);
+    ui->editLog->moveCursor(QTextCursor::End);
+}
+
+void MainWindow::clearLog()
+{
+    ui->editLog->clear();
+
+}
@@ -6,10 +6,15 @@
 #include <QCloseEvent>
 #include <QTimer>
 #include <QPixmap>
-#include <QMutex>
 #include <QPointer>
+#include <QElapsedTimer>
+#include <QSet>
 #include "funcs.h"
 #include "gstplayer.h"
+#include "gstrecorder.h"
+#include "captureengine.h"
+#include "animationwriter.h"
+#include "imageencoder.h"
 
 namespace Ui {
 class MainWindow;
@@ -22,45 +27,54 @@ class MainWindow : public QMainWindow
     Q_OBJECT
 
 public:
-    enum ZCaptureMode {
-        FullScreen=0,
-        CurrentScreen=1,
-        WindowUnderCursor=2,
-        Region=3,
-        ChildWindow=4
+    // GUI-only capture mode, listed after the ZCaptureEngine::ZCaptureMode values
+    enum ZGuiCaptureMode {
+        ChildWindow=ZCaptureEngine::Region+1
     };
-    Q_ENUM(ZCaptureMode)
+    Q_ENUM(ZGuiCaptureMode)
 
     enum ZCaptureReason {
         PreInit=0,
         UserSingle=1,
-        Autocapture=2,
-        SilentHotkey=3
+        SilentHotkey=2
     };
     Q_ENUM(ZCaptureReason)
 
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow() override;
     int capMode();
+    static bool isCaptureServiceEnabled();
 
 private:
     Ui::MainWindow *ui;
     QPointer<QxtGlobalShortcut> keyInteractive;
     QPointer<QxtGlobalShortcut> keySilent;
     ZGSTPlayer beepPlayer;
-    QMutex autoCaptureMutex;
-    QImage savedAutocapImage;
-    QTimer autocaptureTimer;
+    ZGSTRecorder recorder;
+    ZCaptureEngine engine;
+    QSet<QString> pendingNotifications;
+    QString lastQueuedFile;
+    ZAnimationWriter animationWriter;
+    QTimer recordTimer;
+    QElapsedTimer animationTime;
     QPixmap snapshot;
     QString saveDialogFilter;
     QRect lastGrabbedRegion;
     QRect lastRegion;
     bool saved { true };
+    bool recordGrabbing { false };
 
     void centerWindow();
     void loadSettings();
     void doCapture(const ZCaptureReason reason);
+    QString nextFileName(const QString &extension);
     bool saveSnapshot(const QString& filename);
+    bool saveSnapshotAsync(const QString& filename, const ZImageEncoder::ZEncoderOptions &options, bool notify);
+    ZImageEncoder::ZEncoderOptions encoderOptions(bool autocapture) const;
+    ZCaptureEngine::ZCaptureSettings captureSettings() const;
+    void saveAutocaptureSnapshot();
+    bool startAnimation();
+    void finishAnimation();
     void playSound(const QString& filename);
 
     void hideWindow();
@@ -74,14 +88,20 @@ public Q_SLOTS:
     void hotkeyInteractive();
     void actionCapture();
     void actionAutoCapture(bool state);
+    void actionRecord(bool state);
     void interactiveCapture();
     void silentCaptureAndSave();
-    void autoCapture();
+    void autocaptureFrame(const QImage& frame);
+    void autocaptureFailed(const QString& message);
+    void recordFrame();
     bool saveAs();
     void playSample();
     void saveDirSelect();
     void autocaptureSndSelect();
     void copyToClipboard();
+    void snapshotSaved(const QString& filename);
+    void snapshotSaveFailed(const QString& filename, const QString& error);
+    void snapshotDropped(const QString& filename);
     void windowGrabbed(const QPixmap& pic, const QRect &region);
     void regionGrabbed(const QPixmap& pic, const QRect &region);
     void rebindHotkeys();
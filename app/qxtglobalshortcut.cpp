@@ -36,6 +36,7 @@
 
 #include "qxtglobalshortcut.h"
 #include "xcbtools.h"
+#include "keysymcache.h"
 
 /*
     Example usage:
@@ -102,6 +103,8 @@ QxtGlobalShortcutFilter::QxtGlobalShortcutFilter(QObject *parent)
     : ZAbstractXCBEventListener(parent)
 {
     ZXCBTools::addEventListener(this,XCB_KEY_PRESS);
+    connect(ZXCBTools::keySymbols(),&ZKeySymbolsCache::mappingChanged,
+            this,&QxtGlobalShortcutFilter::remapShortcuts,Qt::QueuedConnection);
 }
 
 QxtGlobalShortcutFilter::~QxtGlobalShortcutFilter()
@@ -109,6 +112,12 @@ QxtGlobalShortcutFilter::~QxtGlobalShortcutFilter()
     ZXCBTools::removeEventListener(this);
 }
 
+QxtNativeShortcut QxtGlobalShortcutFilter::nativeShortcut(QxtGlobalShortcut *shortcut)
+{
+    return QxtNativeShortcut(ZXCBTools::nativeKeycode(shortcut->m_key, shortcut->m_mods),
+                             ZXCBTools::nativeModifiers(shortcut->m_mods));
+}
+
 bool QxtGlobalShortcutFilter::addShortcut(QxtGlobalShortcut *shortcut)
 {
     if (shortcut == nullptr)
@@ -116,11 +125,15 @@ bool QxtGlobalShortcutFilter::addShortcut(QxtGlobalShortcut *shortcut)
     if (m_shortcuts.contains(shortcut))
         return true;
 
-    const xcb_keycode_t nativeKey = ZXCBTools::nativeKeycode(shortcut->m_key, shortcut->m_mods);
-    const uint16_t nativeMods = ZXCBTools::nativeModifiers(shortcut->m_mods);
-    const bool res = ZXCBTools::registerShortcut(nativeKey, nativeMods);
+    // native key is resolved once here, key press dispatch is a hash lookup
+    const QxtNativeShortcut native = nativeShortcut(shortcut);
+    const bool res = ZXCBTools::registerShortcut(native.first, native.second);
     if (res) {
         m_shortcuts.append(shortcut);
+        m_nativeKeys.insert(shortcut, native);
+
+        QMutexLocker locker(&m_nativeShortcutsMutex);
+        m_nativeShortcuts.insert(native, shortcut);
     } else {
         qWarning() << "QxtGlobalShortcut failed to register";
     }
@@ -134,31 +147,56 @@ bool QxtGlobalShortcutFilter::removeShortcut(QxtGlobalShortcut *shortcut)
     bool res = false;
     if (!m_shortcuts.contains(shortcut)) return res;
 
-    const xcb_keycode_t nativeKey = ZXCBTools::nativeKeycode(shortcut->m_key, shortcut->m_mods);
-    const uint16_t nativeMods = ZXCBTools::nativeModifiers(shortcut->m_mods);
-    res = ZXCBTools::unregisterShortcut(nativeKey, nativeMods);
+    const QxtNativeShortcut native = m_nativeKeys.value(shortcut);
+    res = ZXCBTools::unregisterShortcut(native.first, native.second);
     if (res) {
         m_shortcuts.removeAll(shortcut);
+        m_nativeKeys.remove(shortcut);
+
+        QMutexLocker locker(&m_nativeShortcutsMutex);
+        m_nativeShortcuts.remove(native, shortcut);
     } else {
         qWarning() << "QxtGlobalShortcut failed to unregister";
     }
     return res;
 }
 
+// Called from XCB event loop thread
 void QxtGlobalShortcutFilter::activateShortcut(xcb_keycode_t nativeKey, uint16_t nativeMods)
+{
+    QMutexLocker locker(&m_nativeShortcutsMutex);
+
+    const auto range = std::as_const(m_nativeShortcuts).equal_range(QxtNativeShortcut(nativeKey, nativeMods));
+    for (auto it = range.first; it != range.second; ++it) {
+        QxtGlobalShortcut* sc = it.value();
+        if (sc->isEnabled()) {
+            QMetaObject::invokeMethod(sc,[sc](){
+                Q_EMIT sc->activated();
+            },Qt::QueuedConnection);
+        }
+    }
+}
+
+// Keyboard mapping changed, native keycodes are resolved and grabbed again
+void QxtGlobalShortcutFilter::remapShortcuts()
 {
     for (const auto* obj : std::as_const(m_shortcuts)) {
         auto* sc = const_cast<QxtGlobalShortcut *>(qobject_cast<const QxtGlobalShortcut *>(obj));
-        if (sc && sc->isEnabled()) {
-            const xcb_keycode_t nativeKeySc = ZXCBTools::nativeKeycode(sc->m_key, sc->m_mods);
-            const uint16_t nativeModsSc = ZXCBTools::nativeModifiers(sc->m_mods);
-            if ((nativeKey == nativeKeySc) &&
-                    (nativeMods == nativeModsSc)) {
-                QMetaObject::invokeMethod(sc,[sc](){
-                    Q_EMIT sc->activated();
-                },Qt::QueuedConnection);
-            }
-        }
+        if (sc == nullptr) continue;
+
+        const QxtNativeShortcut oldNative = m_nativeKeys.value(sc);
+        const QxtNativeShortcut native = nativeShortcut(sc);
+        if (native == oldNative) continue;
+
+        ZXCBTools::unregisterShortcut(oldNative.first, oldNative.second);
+        if (!ZXCBTools::registerShortcut(native.first, native.second))
+            qWarning() << "QxtGlobalShortcut failed to register after keyboard mapping change";
+
+        m_nativeKeys.insert(sc, native);
+
+        QMutexLocker locker(&m_nativeShortcutsMutex);
+        m_nativeShortcuts.remove(oldNative, sc);
+        m_nativeShortcuts.insert(native, sc);
     }
 }
 
@@ -191,14 +229,13 @@ bool QxtGlobalShortcutFilter::setupShortcut(QxtGlobalShortcut *shortcut)
 
 void QxtGlobalShortcutFilter::nativeEventHandler(const xcb_generic_event_t *event)
 {
-    const auto *kev = reinterpret_cast<const xcb_key_press_event_t *>(event);
+    if (event == nullptr) return;
 
-    if (kev != nullptr) {
-        xcb_keycode_t keycode = kev->detail;
-        const unsigned short modifiersMask = (XCB_MOD_MASK_1 | XCB_MOD_MASK_CONTROL | // NOLINT
-                                              XCB_MOD_MASK_4 | XCB_MOD_MASK_SHIFT); // NOLINT
-        uint16_t keystate = kev->state & modifiersMask;
-        // Mod1Mask == Alt, Mod4Mask == Meta
-        activateShortcut(keycode, keystate);
-    }
+    const auto *kev = reinterpret_cast<const xcb_key_press_event_t *>(event);
+    xcb_keycode_t keycode = kev->detail;
+    const unsigned short modifiersMask = (XCB_MOD_MASK_1 | XCB_MOD_MASK_CONTROL | // NOLINT
+                                          XCB_MOD_MASK_4 | XCB_MOD_MASK_SHIFT); // NOLINT
+    uint16_t keystate = kev->state & modifiersMask;
+    // Mod1Mask == Alt, Mod4Mask == Meta
+    activateShortcut(keycode, keystate);
 }
@@ -33,6 +33,8 @@
 
 #include <QObject>
 #include <QKeySequence>
+#include <QHash>
+#include <QMutex>
 #include <xcb/xcb.h>
 #include "xcbtools.h"
 
@@ -76,11 +78,18 @@ private:
     Q_DISABLE_COPY(QxtGlobalShortcutFilter)
 
     QObjectList m_shortcuts;
+    QHash<QxtGlobalShortcut*, QxtNativeShortcut> m_nativeKeys; // owner thread only
+    QMultiHash<QxtNativeShortcut, QxtGlobalShortcut*> m_nativeShortcuts; // key dispatch lookup
+    QMutex m_nativeShortcutsMutex;
 
+    static QxtNativeShortcut nativeShortcut(QxtGlobalShortcut* shortcut);
     bool addShortcut(QxtGlobalShortcut* shortcut);
     bool removeShortcut(QxtGlobalShortcut* shortcut);
     void activateShortcut(xcb_keycode_t nativeKey, uint16_t nativeMods);
 
+private Q_SLOTS:
+    void remapShortcuts();
+
 public:
     QxtGlobalShortcutFilter(QObject* parent = nullptr);
     ~QxtGlobalShortcutFilter() override;
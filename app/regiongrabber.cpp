@@ -26,6 +26,8 @@
 #include <QToolTip>
 #include <QTimer>
 
+#include <utility>
+
 #include "funcs.h"
 #include "xcbtools.h"
 
@@ -49,15 +51,19 @@ RegionGrabber::RegionGrabber(QWidget *parent, const QRect &startSelection, bool
 
 RegionGrabber::~RegionGrabber() = default;
 
+// The overlay is shown once the screen image arrives from the capture thread
 void RegionGrabber::init(bool includePointer)
 {
-    pixmap = ZXCBTools::getWindowPixmap(ZXCBTools::appRootWindow(), includePointer);
-    resize(pixmap.size());
-    move(0, 0);
-    setCursor(Qt::CrossCursor);
-    show();
-    grabMouse();
-    grabKeyboard();
+    const xcb_window_t root = ZXCBTools::appRootWindow();
+    ZXCBTools::requestWindowImage(root,this,[this,root,includePointer](QImage image){
+        pixmap = ZXCBTools::windowImageToPixmap(std::move(image), root, includePointer);
+        resize(pixmap.size());
+        move(0, 0);
+        setCursor(Qt::CrossCursor);
+        show();
+        grabMouse();
+        grabKeyboard();
+    });
 }
 
 static void drawRect(QPainter *painter, const QRect &r, const QColor &outline, const QColor &fill = QColor())
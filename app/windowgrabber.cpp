@@ -40,7 +40,9 @@ WindowGrabber::WindowGrabber(QWidget *parent, bool includeDecorations, bool blen
 
     xcb_window_t child = ZXCBTools::windowUnderCursor(includeDecorations);
     QPixmap pm(ZXCBTools::getWindowPixmap(child, blendPointer));
+    QVector<QRect> windows;
     ZXCBTools::getWindowsRecursive(windows, child);
+    index = ZWindowIndex(windows);
     geom = ZXCBTools::getWindowGeometry(child);
 
     QPalette p = palette();
@@ -66,13 +68,13 @@ void WindowGrabber::mousePressEvent(QMouseEvent *event)
     } else {
         if (current != -1) {
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-            QRect windowRegion(event->globalPosition().toPoint() - event->pos() + windows.at(current).topLeft(),
-                               windows.at(current).size());
+            QRect windowRegion(event->globalPosition().toPoint() - event->pos() + index.window(current).topLeft(),
+                               index.window(current).size());
 #else
-            QRect windowRegion(event->globalPos() - event->pos() + windows.at(current).topLeft(),
-                               windows.at(current).size());
+            QRect windowRegion(event->globalPos() - event->pos() + index.window(current).topLeft(),
+                               index.window(current).size());
 #endif
-            Q_EMIT windowGrabbed(palette().brush(backgroundRole()).texture().copy(windows.at(current)),
+            Q_EMIT windowGrabbed(palette().brush(backgroundRole()).texture().copy(index.window(current)),
                                  windowRegion);
         } else {
             Q_EMIT windowGrabbed(QPixmap(),QRect());
@@ -130,12 +132,7 @@ void WindowGrabber::wheelEvent(QWheelEvent *event)
 // dragging the mouse forwards while keeping the right mouse button pressed.
 void WindowGrabber::increaseScope(const QPoint &pos)
 {
-    for (int i = current + 1; i < windows.size(); i++) {
-        if (windows.at(i).contains(pos)) {
-            current = i;
-            break;
-        }
-    }
+    current = index.largerWindowAt(pos, current);
     repaint();
 }
 
@@ -144,12 +141,7 @@ void WindowGrabber::increaseScope(const QPoint &pos)
 // dragging the mouse backwards while keeping the right mouse button pressed.
 void WindowGrabber::decreaseScope( const QPoint &pos )
 {
-    for (int i = current - 1; i >= 0; i--) {
-        if (windows.at(i).contains(pos)) {
-            current = i;
-            break;
-        }
-    }
+    current = index.smallerWindowAt(pos, current);
     repaint();
 }
 
@@ -157,11 +149,7 @@ void WindowGrabber::decreaseScope( const QPoint &pos )
 // containing the mouse pointer.
 int WindowGrabber::windowIndex(const QPoint &pos) const
 {
-    for (int i = 0; i < windows.size(); i++) {
-        if (windows[i].contains( pos ))
-            return i;
-    }
-    return -1;
+    return index.windowAt(pos);
 }
 
 // Draws a border around the (child) window currently containing the pointer
@@ -174,7 +162,7 @@ void WindowGrabber::paintEvent(QPaintEvent *event)
         p.begin(this);
         p.fillRect(rect(), palette().brush(backgroundRole()));
         p.setPen(QPen(Qt::red, 3));
-        p.drawRect(windows.at(current).adjusted(0, 0, -1, -1));
+        p.drawRect(index.window(current).adjusted(0, 0, -1, -1));
         p.end();
     }
 }
@@ -22,17 +22,18 @@
 #define WINDOWGRABBER_H
 
 #include <QDialog>
-#include <QVector>
 
 #include <xcb/xcb.h>
 #include <xcb/xcb_image.h>
 
+#include "windowindex.h"
+
 class WindowGrabber : public QDialog
 {
     Q_OBJECT
 
 private:
-    QVector<QRect> windows;
+    ZWindowIndex index;
     int current { -1 };
     int yPos { -1 };
 
@@ -0,0 +1,395 @@
+#include <QtEndian>
+#include <QDebug>
+
+#include <cstring>
+#include <zlib.h>
+
+#ifdef WITH_WEBP
+#include <webp/encode.h>
+#endif
+
+#include "animationwriter.h"
+#include "pngwriter.h"
+#include "coredefs.h"
+
+namespace {
+const int defaultDelayMS = 1000;
+const int maxDelayMS = 65535;
+const int maxCompression = 9;
+const int maxQuality = 100;
+
+void appendUInt32(QByteArray &data, quint32 value)
+{
+    const quint32 be = qToBigEndian(value);
+    data.append(reinterpret_cast<const char *>(&be), sizeof(be));
+}
+
+void appendUInt16(QByteArray &data, quint16 value)
+{
+    const quint16 be = qToBigEndian(value);
+    data.append(reinterpret_cast<const char *>(&be), sizeof(be));
+}
+}
+
+ZAnimationWriter::ZAnimationWriter() = default;
+
+ZAnimationWriter::~ZAnimationWriter()
+{
+    if (m_active)
+        finish();
+}
+
+bool ZAnimationWriter::isWebPSupported()
+{
+#ifdef WITH_WEBP
+    return true;
+#else
+    return false;
+#endif
+}
+
+QString ZAnimationWriter::fileExtension(ZAnimationFormat format)
+{
+    switch (format) {
+        case WebP: return QSL("webp");
+        case APNG: break;
+    }
+    return QSL("png");
+}
+
+bool ZAnimationWriter::isActive() const
+{
+    return m_active;
+}
+
+quint32 ZAnimationWriter::framesCount() const
+{
+    return m_framesCount;
+}
+
+QString ZAnimationWriter::errorString() const
+{
+    return m_errorString;
+}
+
+void ZAnimationWriter::setError(const QString &message)
+{
+    m_errorString = message;
+    qWarning() << message;
+}
+
+bool ZAnimationWriter::start(const QString &fileName, ZAnimationFormat format, int quality, int compression)
+{
+    if (m_active)
+        finish();
+
+    m_errorString.clear();
+    if (format == WebP && !isWebPSupported()) {
+        setError(QSL("Animated WebP support disabled"));
+        return false;
+    }
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        setError(QSL("Unable to create animation file %1: %2").arg(fileName,m_file.errorString()));
+        return false;
+    }
+
+    m_quality = qBound(0, quality, maxQuality);
+    m_compression = qBound(0, compression, maxCompression);
+
+    m_format = format;
+    m_canvas = QImage();
+    m_pending = QImage();
+    m_pendingRect = QRect();
+    m_pendingTimestamp = 0;
+    m_lastDelay = 0;
+    m_framesCount = 0;
+    m_sequence = 0;
+    m_animCtlPos = -1;
+
+    // IHDR follows with the first frame, its write is checked by writeChunk()
+    if (m_format == APNG) {
+        static const char pngSignature[] = { '\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n' };
+        if (m_file.write(pngSignature, sizeof(pngSignature)) != sizeof(pngSignature)) {
+            setError(QSL("Unable to write animation file %1: %2").arg(fileName,m_file.errorString()));
+            m_file.close();
+            return false;
+        }
+    }
+
+    m_active = true;
+    return true;
+}
+
+// Bounding box of the pixels that differ from the canvas
+QRect ZAnimationWriter::changedRect(const QImage &frame) const
+{
+    const int width = frame.width();
+    const auto rowBytes = static_cast<size_t>(width) * sizeof(QRgb);
+
+    int top = -1;
+    int bottom = -1;
+    int left = width;
+    int right = -1;
+
+    for (int y = 0; y < frame.height(); y++) {
+        const auto *a = reinterpret_cast<const QRgb *>(frame.constScanLine(y));
+        const auto *b = reinterpret_cast<const QRgb *>(m_canvas.constScanLine(y));
+        if (memcmp(a, b, rowBytes) == 0) continue;
+
+        if (top < 0)
+            top = y;
+        bottom = y;
+
+        int x = 0;
+        while (x < left && a[x] == b[x]) // NOLINT
+            x++;
+        left = x;
+
+        x = width - 1;
+        while (x > right && a[x] == b[x]) // NOLINT
+            x--;
+        right = x;
+    }
+
+    if (top < 0) return QRect();
+
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+bool ZAnimationWriter::addFrame(const QImage &frame, int timestamp)
+{
+    if (!m_active || frame.isNull()) return false;
+
+    const QImage image = frame.convertToFormat(QImage::Format_RGB32);
+
+    if (!m_canvas.isNull() && image.size() != m_canvas.size()) {
+        qWarning() << "Animation: frame size changed, frame dropped";
+        return false;
+    }
+
+    if (m_format == WebP) {
+        m_canvas = image;
+        return addWebPFrame(image, timestamp);
+    }
+
+    if (m_canvas.isNull()) {
+        // IHDR and the default image must cover the whole canvas
+        QByteArray header;
+        appendUInt32(header, static_cast<quint32>(image.width()));
+        appendUInt32(header, static_cast<quint32>(image.height()));
+        header.append(static_cast<char>(8)); // bit depth // NOLINT
+        header.append(static_cast<char>(2)); // color type: RGB
+        header.append(3, static_cast<char>(0)); // compression, filter, interlace
+        if (!writeChunk("IHDR", header)) return false;
+
+        m_animCtlPos = m_file.pos();
+        if (!writeAnimationControl()) return false;
+
+        m_canvas = image.copy();
+        m_pendingRect = m_canvas.rect();
+    } else {
+        const QRect rect = changedRect(image);
+
+        // unchanged frame just extends the previous frame delay
+        if (rect.isEmpty()) return true;
+
+        if (!writePendingFrame(timestamp - m_pendingTimestamp)) return false;
+
+        const auto rowBytes = static_cast<size_t>(rect.width()) * sizeof(QRgb);
+        for (int y = rect.top(); y <= rect.bottom(); y++) {
+            memcpy(reinterpret_cast<QRgb *>(m_canvas.scanLine(y)) + rect.left(),
+                   reinterpret_cast<const QRgb *>(image.constScanLine(y)) + rect.left(),
+                   rowBytes);
+        }
+        m_pendingRect = rect;
+    }
+
+    // the frame is written when the next one arrives, as APNG needs the delay in advance
+    m_pending = m_canvas.copy(m_pendingRect);
+    m_pendingTimestamp = timestamp;
+    return true;
+}
+
+bool ZAnimationWriter::writeChunk(const char *type, const QByteArray &data)
+{
+    QByteArray chunk;
+    appendUInt32(chunk, static_cast<quint32>(data.size()));
+    chunk.append(type, 4); // NOLINT
+    chunk.append(data);
+
+    const uLong crc = crc32(crc32(0L, Z_NULL, 0),
+                            reinterpret_cast<const Bytef *>(chunk.constData() + 4), // NOLINT
+                            static_cast<uInt>(chunk.size() - 4)); // NOLINT
+    appendUInt32(chunk, static_cast<quint32>(crc));
+
+    if (m_file.write(chunk) != chunk.size()) {
+        setError(QSL("Unable to write animation file %1: %2").arg(m_file.fileName(),m_file.errorString()));
+        return false;
+    }
+    return true;
+}
+
+bool ZAnimationWriter::writeAnimationControl()
+{
+    QByteArray control;
+    appendUInt32(control, m_framesCount);
+    appendUInt32(control, 0); // loop forever
+    return writeChunk("acTL", control);
+}
+
+bool ZAnimationWriter::writePendingFrame(int delay)
+{
+    QByteArray control;
+    appendUInt32(control, m_sequence++);
+    appendUInt32(control, static_cast<quint32>(m_pendingRect.width()));
+    appendUInt32(control, static_cast<quint32>(m_pendingRect.height()));
+    appendUInt32(control, static_cast<quint32>(m_pendingRect.x()));
+    appendUInt32(control, static_cast<quint32>(m_pendingRect.y()));
+    appendUInt16(control, static_cast<quint16>(qBound(1, delay, maxDelayMS)));
+    appendUInt16(control, 1000); // delay in milliseconds // NOLINT
+    control.append(static_cast<char>(0)); // dispose: none
+    control.append(static_cast<char>(0)); // blend: source
+    if (!writeChunk("fcTL", control)) return false;
+
+    const QByteArray pixels = ZPngWriter::deflateRect(m_pending, m_pending.rect(), m_compression);
+    if (pixels.isEmpty()) {
+        setError(QSL("Animation: zlib compression failed"));
+        return false;
+    }
+
+    if (m_framesCount == 0) {
+        if (!writeChunk("IDAT", pixels)) return false;
+    } else {
+        QByteArray data;
+        appendUInt32(data, m_sequence++);
+        data.append(pixels);
+        if (!writeChunk("fdAT", data)) return false;
+    }
+
+    m_framesCount++;
+    m_lastDelay = delay;
+    m_pending = QImage();
+    return true;
+}
+
+bool ZAnimationWriter::addWebPFrame(const QImage &frame, int timestamp)
+{
+#ifdef WITH_WEBP
+    if (m_webpEncoder == nullptr) {
+        WebPAnimEncoderOptions options;
+        if (!WebPAnimEncoderOptionsInit(&options)) {
+            setError(QSL("Animation: libwebp version mismatch"));
+            return false;
+        }
+        m_webpEncoder = WebPAnimEncoderNew(frame.width(), frame.height(), &options);
+        if (m_webpEncoder == nullptr) {
+            setError(QSL("Animation: unable to create WebP encoder"));
+            return false;
+        }
+    }
+
+    // lossless at maximum quality, the encoder stores only changed sub-frames itself
+    WebPConfig config;
+    WebPConfigInit(&config);
+    config.lossless = (m_quality >= maxQuality) ? 1 : 0;
+    config.quality = static_cast<float>(m_quality);
+
+    const QImage rgba = frame.convertToFormat(QImage::Format_RGBA8888);
+
+    WebPPicture picture;
+    WebPPictureInit(&picture);
+    picture.use_argb = 1;
+    picture.width = rgba.width();
+    picture.height = rgba.height();
+    if (!WebPPictureImportRGBA(&picture, rgba.constBits(), rgba.bytesPerLine())) {
+        setError(QSL("Animation: WebP picture allocation failed"));
+        return false;
+    }
+
+    const bool res = (WebPAnimEncoderAdd(m_webpEncoder, &picture, timestamp, &config) != 0);
+    WebPPictureFree(&picture);
+    if (!res) {
+        setError(QSL("Animation: WebP encoder error: %1")
+                 .arg(QString::fromUtf8(WebPAnimEncoderGetError(m_webpEncoder))));
+        return false;
+    }
+
+    m_framesCount++;
+    if (m_framesCount > 1)
+        m_lastDelay = timestamp - m_pendingTimestamp;
+    m_pendingTimestamp = timestamp;
+    return true;
+#else
+    Q_UNUSED(frame)
+    Q_UNUSED(timestamp)
+    return false;
+#endif
+}
+
+bool ZAnimationWriter::finishWebP(int timestamp)
+{
+#ifdef WITH_WEBP
+    if (m_webpEncoder == nullptr) return false;
+
+    bool res = (WebPAnimEncoderAdd(m_webpEncoder, nullptr, timestamp, nullptr) != 0);
+
+    WebPData data;
+    WebPDataInit(&data);
+    if (res)
+        res = (WebPAnimEncoderAssemble(m_webpEncoder, &data) != 0);
+
+    if (res) {
+        const auto size = static_cast<qint64>(data.size);
+        if (m_file.write(reinterpret_cast<const char *>(data.bytes), size) != size) {
+            setError(QSL("Unable to write animation file %1: %2").arg(m_file.fileName(),m_file.errorString()));
+            res = false;
+        }
+    } else {
+        setError(QSL("Animation: WebP encoder error: %1")
+                 .arg(QString::fromUtf8(WebPAnimEncoderGetError(m_webpEncoder))));
+    }
+
+    WebPDataClear(&data);
+    WebPAnimEncoderDelete(m_webpEncoder);
+    m_webpEncoder = nullptr;
+    return res;
+#else
+    Q_UNUSED(timestamp)
+    return false;
+#endif
+}
+
+bool ZAnimationWriter::finish()
+{
+    if (!m_active) return false;
+    m_active = false;
+
+    const int lastDelay = (m_lastDelay > 0) ? m_lastDelay : defaultDelayMS;
+
+    bool res = false;
+    if (m_format == WebP) {
+        res = finishWebP(m_pendingTimestamp + lastDelay);
+    } else if (!m_pending.isNull()) {
+        res = writePendingFrame(lastDelay) && writeChunk("IEND", QByteArray());
+
+        // now the frames count is known
+        if (res && m_file.seek(m_animCtlPos)) {
+            res = writeAnimationControl();
+        } else {
+            res = false;
+        }
+    }
+
+    m_canvas = QImage();
+    m_pending = QImage();
+
+    if (!res || m_framesCount == 0) {
+        m_file.remove();
+        return false;
+    }
+
+    m_file.close();
+    return true;
+}
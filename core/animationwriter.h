@@ -0,0 +1,69 @@
+#ifndef ANIMATIONWRITER_H
+#define ANIMATIONWRITER_H
+
+#include <QImage>
+#include <QFile>
+#include <QRect>
+#include <QByteArray>
+
+#ifdef WITH_WEBP
+#include <webp/mux.h>
+#endif
+
+// Accumulates frames into a single animated PNG or animated WebP file.
+// Each frame is stored as a delta covering only the bounding box of the
+// pixels changed since the previous frame.
+class ZAnimationWriter
+{
+public:
+    enum ZAnimationFormat {
+        APNG=0,
+        WebP=1
+    };
+
+private:
+    Q_DISABLE_COPY(ZAnimationWriter)
+
+    ZAnimationFormat m_format { APNG };
+    QFile m_file;
+    QString m_errorString;
+    QImage m_canvas;   // last complete frame
+    QImage m_pending;  // delta frame waiting for its delay
+    QRect m_pendingRect;
+    int m_pendingTimestamp { 0 };
+    int m_lastDelay { 0 };
+    int m_compression { 0 };
+    int m_quality { 0 };
+    quint32 m_framesCount { 0 };
+    quint32 m_sequence { 0 };
+    qint64 m_animCtlPos { -1 };
+    bool m_active { false };
+
+#ifdef WITH_WEBP
+    WebPAnimEncoder* m_webpEncoder { nullptr };
+#endif
+
+    QRect changedRect(const QImage &frame) const;
+    bool writeChunk(const char *type, const QByteArray &data);
+    bool writeAnimationControl();
+    bool writePendingFrame(int delay);
+    bool addWebPFrame(const QImage &frame, int timestamp);
+    bool finishWebP(int timestamp);
+    void setError(const QString &message);
+
+public:
+    ZAnimationWriter();
+    ~ZAnimationWriter();
+
+    static bool isWebPSupported();
+    static QString fileExtension(ZAnimationFormat format);
+
+    bool start(const QString &fileName, ZAnimationFormat format, int quality, int compression);
+    bool addFrame(const QImage &frame, int timestamp);
+    bool finish();
+    bool isActive() const;
+    quint32 framesCount() const;
+    QString errorString() const;
+};
+
+#endif // ANIMATIONWRITER_H
@@ -0,0 +1,438 @@
+#include <QGuiApplication>
+#include <QScreen>
+#include <QCursor>
+#include <QRegularExpression>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+
+#include <utility>
+
+#include "captureengine.h"
+#include "damagewatcher.h"
+#include "xcbtools.h"
+#include "coredefs.h"
+
+ZCaptureEngine::ZCaptureEngine(QObject *parent)
+    : QObject(parent)
+{
+    m_autocaptureTimer.setSingleShot(false);
+    m_damageTimer.setSingleShot(true);
+    m_settleTimer.setSingleShot(true);
+
+    // forwarded from the encoder pool as is, receivers choose the connection type
+    connect(&m_encoderQueue,&ZEncoderQueue::saved,this,&ZCaptureEngine::saved,Qt::DirectConnection);
+    connect(&m_encoderQueue,&ZEncoderQueue::failed,this,&ZCaptureEngine::saveFailed,Qt::DirectConnection);
+    connect(&m_encoderQueue,&ZEncoderQueue::dropped,this,&ZCaptureEngine::dropped,Qt::DirectConnection);
+    connect(&m_encoderQueue,&ZEncoderQueue::drained,this,&ZCaptureEngine::autocaptureResumed);
+
+    connect(&m_autocaptureTimer,&QTimer::timeout,this,&ZCaptureEngine::autoCapture);
+    connect(&m_settleTimer,&QTimer::timeout,this,&ZCaptureEngine::autocaptureSettled);
+    connect(&m_damageTimer,&QTimer::timeout,this,[this](){
+        if (m_damageWatcher)
+            m_damageWatcher->acknowledge();
+        m_lastAutocaptureTime.start();
+        autoCapture();
+    });
+
+    setSettings(m_settings);
+}
+
+ZCaptureEngine::~ZCaptureEngine()
+{
+    stopAutocapture();
+    m_encoderQueue.waitForDone();
+}
+
+void ZCaptureEngine::setSettings(const ZCaptureEngine::ZCaptureSettings &settings)
+{
+    m_settings = settings;
+
+    m_encoderQueue.setMaxDepth(m_settings.encoderQueueDepth);
+    m_encoderQueue.setPolicy(m_settings.encoderPolicy);
+
+    for (ZChangeDetector* detector : { &m_detector, &m_settleDetector }) {
+        detector->setMinChangedPixels(m_settings.minChangedPixels);
+        detector->setMinChangedTiles(m_settings.minChangedTiles);
+        detector->setIgnoreRects(m_settings.ignoreRects);
+    }
+}
+
+const ZCaptureEngine::ZCaptureSettings &ZCaptureEngine::settings() const
+{
+    return m_settings;
+}
+
+void ZCaptureEngine::setCounter(int counter)
+{
+    m_counter = counter;
+}
+
+int ZCaptureEngine::counter() const
+{
+    return m_counter;
+}
+
+// Grabs the area for the mode, rect is used in region mode only. The captured
+// root-relative area is returned in region.
+QPixmap ZCaptureEngine::grab(ZCaptureEngine::ZCaptureMode mode, const QRect &rect, bool includePointer,
+                             bool includeDecorations, QRect *region)
+{
+    QPixmap snapshot;
+
+    switch (mode) {
+        case FullScreen:
+            snapshot = ZXCBTools::getWindowPixmap(ZXCBTools::appRootWindow(), includePointer);
+            *region = QRect(QPoint(0,0),snapshot.size());
+            break;
+        case CurrentScreen: {
+            const QRect screenRect = currentScreenGeometry();
+            if (screenRect.isNull()) break;
+
+            *region = screenRect;
+            snapshot = ZXCBTools::getRootPixmap(*region, includePointer);
+            break;
+        }
+        case WindowUnderCursor:
+            snapshot = ZXCBTools::grabCurrent(includeDecorations, includePointer, region);
+            break;
+        case Region:
+            *region = rect;
+            snapshot = ZXCBTools::getRootPixmap(*region, includePointer);
+            break;
+    }
+
+    return snapshot;
+}
+
+// Asynchronous grab(), the image is transferred on the capture thread while
+// the caller keeps running. The callback runs in the thread of context with
+// the snapshot and its root-relative area, or never when context is destroyed.
+void ZCaptureEngine::requestGrab(ZCaptureEngine::ZCaptureMode mode, const QRect &rect, bool includePointer,
+                                 bool includeDecorations, QObject *context, const ZSnapshotCallback &callback)
+{
+    QRect region = rect;
+
+    switch (mode) {
+        case FullScreen:
+        case WindowUnderCursor: {
+            QRect windowRegion;
+            const xcb_window_t window = (mode == FullScreen) ? ZXCBTools::appRootWindow()
+                                        : ZXCBTools::currentWindow(includeDecorations, &windowRegion);
+            ZXCBTools::requestWindowImage(window,context,
+                                          [mode,window,windowRegion,includePointer,callback](QImage image){
+                const QPixmap snapshot = ZXCBTools::windowImageToPixmap(std::move(image), window, includePointer);
+                if (mode == FullScreen) {
+                    callback(snapshot, QRect(QPoint(0,0),snapshot.size()));
+                } else {
+                    callback(snapshot, windowRegion);
+                }
+            });
+            return;
+        }
+        case CurrentScreen:
+            region = currentScreenGeometry();
+            break;
+        case Region:
+            break;
+    }
+
+    ZXCBTools::requestRootImage(region,context,[region,includePointer,callback](QImage image){
+        callback(ZXCBTools::rootImageToPixmap(std::move(image), region, includePointer), region);
+    });
+}
+
+// Available geometry of the screen with the pointer, null without screens
+QRect ZCaptureEngine::currentScreenGeometry()
+{
+    QScreen *screen = QGuiApplication::screenAt(QCursor::pos());
+    if (screen == nullptr)
+        screen = QGuiApplication::primaryScreen();
+    if (screen == nullptr) return QRect();
+
+    return screen->availableGeometry();
+}
+
+QPixmap ZCaptureEngine::grab(QRect *region) const
+{
+    return grab(m_settings.mode, m_settings.region, m_settings.includePointer, m_settings.includeDecorations,
+                region);
+}
+
+QString ZCaptureEngine::generateFileName(int counter, const QString &tmpl, const QSize &size, const QString &dir,
+                                         const QString &extension, bool withoutPath)
+{
+    const int numberBase = 10;
+
+    QString uniq = tmpl;
+    if (uniq.isEmpty())
+        uniq = QSL("%NN");
+
+    QRegularExpression exp(QSL("%(\\w+)"));
+    QRegularExpressionMatch mexp = exp.match(uniq);
+    for (int i=0; i < mexp.lastCapturedIndex(); i++) {
+        const int length = mexp.capturedLength(i);
+        const int pos = mexp.capturedStart(i);
+        if (length>=2) {
+            const QString tl = uniq.mid(pos+1,length-1);
+            if (tl.contains(QRegularExpression(QSL("N+")))) {
+                uniq.replace(pos, length, QSL("%1").arg(counter,tl.length(),numberBase,QChar('0')));
+            } else if (tl == QSL("w")) {
+                uniq.replace(pos, length, QSL("%1").arg(size.width()));
+            } else if (tl == QSL("h")) {
+                uniq.replace(pos, length, QSL("%1").arg(size.height()));
+            } else if (tl == QSL("y")) {
+                uniq.replace(pos, length, QDateTime::currentDateTime().toString(QSL("yyyy")));
+            } else if (tl == QSL("m")) {
+                uniq.replace(pos, length, QDateTime::currentDateTime().toString(QSL("MM")));
+            } else if (tl == QSL("d")) {
+                uniq.replace(pos, length, QDateTime::currentDateTime().toString(QSL("dd")));
+            } else if (tl == QSL("t")) {
+                uniq.replace(pos, length, QDateTime::currentDateTime().toString(QSL("hh-mm-ss")));
+            }
+        }
+    }
+
+    QDir d(dir);
+    QString ext;
+    if (!extension.isEmpty())
+        ext = QSL(".%1").arg(extension.toLower());
+
+    QFileInfo fi(d.absoluteFilePath(QSL("%1%2").arg(uniq,ext)));
+    int idx = 1;
+    while (fi.exists()) {
+        fi.setFile(d.absoluteFilePath(QSL("%1-%3%2").arg(uniq,ext).arg(idx)));
+        idx++;
+    }
+
+    if (withoutPath)
+        return fi.fileName();
+
+    return fi.absoluteFilePath();
+}
+
+// Advances the counter and returns the full path in the output directory
+QString ZCaptureEngine::nextFileName(const QSize &size, const QString &extension)
+{
+    const QString dir = m_settings.outputDir.isEmpty() ? QDir::currentPath() : m_settings.outputDir;
+    m_counter++;
+    return generateFileName(m_counter, m_settings.fileTemplate, size, dir, extension, false);
+}
+
+bool ZCaptureEngine::saveAsync(const QImage &image, const QString &fileName,
+                               const ZImageEncoder::ZEncoderOptions &options)
+{
+    return m_encoderQueue.enqueue(image, fileName, options);
+}
+
+void ZCaptureEngine::waitForDone()
+{
+    m_encoderQueue.waitForDone();
+}
+
+// Watches the region for changes until stopped. With the XDamage watcher the region
+// is scanned on damage reports only, throttled to the interval, otherwise on the scan timer.
+// The last captured frame stays the reference unless resetReference is set.
+bool ZCaptureEngine::startAutocapture(const QRect &region, bool resetReference)
+{
+    if (region.isEmpty()) return false;
+
+    stopAutocapture();
+    if (resetReference)
+        m_detector.reset();
+
+    m_autocaptureRegion = region;
+    m_autocaptureState = Watching;
+    m_autocaptureActive = true;
+
+    if (m_settings.autocaptureDamage && ZDamageWatcher::isDamageSupported()) {
+        m_damageWatcher = new ZDamageWatcher(this);
+        if (m_damageWatcher->isActive()) {
+            m_damageWatcher->setWatchRegion(m_autocaptureRegion);
+            connect(m_damageWatcher.data(), &ZDamageWatcher::regionDamaged,
+                    this, &ZCaptureEngine::autocaptureDamaged);
+
+            // initial snapshot, as the first scan timer tick does
+            m_lastAutocaptureTime.invalidate();
+            autocaptureDamaged();
+            return true;
+        }
+
+        qWarning() << "XDamage watcher failed, falling back to autocapture scan timer";
+        m_damageWatcher->deleteLater();
+    }
+
+    m_autocaptureTimer.start(m_settings.autocaptureInterval);
+    return true;
+}
+
+void ZCaptureEngine::stopAutocapture()
+{
+    if (m_autocaptureTimer.isActive())
+        m_autocaptureTimer.stop();
+    if (m_damageTimer.isActive())
+        m_damageTimer.stop();
+    if (m_settleTimer.isActive())
+        m_settleTimer.stop();
+    m_autocaptureState = Watching;
+    m_autocaptureActive = false;
+    m_autocapturePaused = false;
+    m_autocaptureGrabbing = false;
+    m_autocaptureRescan = false;
+    m_autocaptureSession++;
+    if (m_damageWatcher)
+        m_damageWatcher->deleteLater();
+}
+
+bool ZCaptureEngine::isAutocaptureActive() const
+{
+    return m_autocaptureActive;
+}
+
+void ZCaptureEngine::autoCapture()
+{
+    // the capture pending in settle state will include any further changes
+    if (!m_autocaptureActive || m_autocapturePaused || m_autocaptureState == Settling) return;
+
+    // the grab in flight may be older than the change reported, scan again after it
+    if (m_autocaptureGrabbing) {
+        m_autocaptureRescan = true;
+        return;
+    }
+
+    // backpressure: with a full queue the frame could only wait for the encoder
+    // in the event loop, so pause scanning until the queue drains
+    if (m_settings.encoderPolicy == ZEncoderQueue::Block && m_encoderQueue.isFull()) {
+        m_autocapturePaused = true;
+        m_autocaptureTimer.stop();
+        return;
+    }
+
+    requestAutocaptureFrame(&ZCaptureEngine::autocaptureScanned);
+}
+
+// The frame is grabbed on the capture thread, so the engine thread keeps handling
+// events meanwhile. A result of a session stopped in the meantime is dropped.
+void ZCaptureEngine::requestAutocaptureFrame(void (ZCaptureEngine::*handler)(QImage &frame))
+{
+    const int session = m_autocaptureSession;
+    m_autocaptureGrabbing = true;
+    ZXCBTools::requestRootImage(m_autocaptureRegion,this,[this,session,handler](QImage frame){
+        if (session != m_autocaptureSession) return;
+
+        m_autocaptureGrabbing = false;
+        (this->*handler)(frame);
+
+        if (m_autocaptureRescan) {
+            m_autocaptureRescan = false;
+            autoCapture();
+        }
+    });
+}
+
+void ZCaptureEngine::autocaptureScanned(QImage &frame)
+{
+    if (!m_autocaptureActive) return;
+
+    if (frame.isNull()) {
+        autocaptureGrabFailed();
+        return;
+    }
+
+    if (!m_detector.update(frame)) return;
+
+    const int interval = m_settings.autocaptureInterval;
+    if (m_settings.autocaptureWait && interval>0) {
+        m_autocaptureState = Settling;
+        if (m_settings.autocaptureStable) {
+            m_settleDetector.reset();
+            m_settleDetector.update(frame);
+            m_settleTime.start();
+        }
+        m_settleTimer.start(interval);
+        return;
+    }
+
+    // the frame used for change detection is exactly what we emit
+    emitFrame(frame);
+}
+
+void ZCaptureEngine::autocaptureSettled()
+{
+    if (!m_autocaptureActive || m_autocaptureState != Settling) return;
+
+    requestAutocaptureFrame(&ZCaptureEngine::autocaptureSettledFrame);
+}
+
+void ZCaptureEngine::autocaptureSettledFrame(QImage &frame)
+{
+    if (!m_autocaptureActive || m_autocaptureState != Settling) return;
+
+    if (frame.isNull()) {
+        m_autocaptureState = Watching;
+        autocaptureGrabFailed();
+        return;
+    }
+
+    // in stable mode, wait until the region stops changing for the whole interval
+    if (m_settings.autocaptureStable && m_settleDetector.update(frame)) {
+        const qint64 maxSettleTime = static_cast<qint64>(m_settings.autocaptureInterval) *
+                                     m_settings.autocaptureMaxSettleIntervals;
+        if (m_settleTime.elapsed() < maxSettleTime) {
+            m_settleTimer.start(m_settings.autocaptureInterval);
+            return;
+        }
+    }
+
+    m_autocaptureState = Watching;
+
+    // take the settled frame as the new reference, so it will not be captured twice
+    m_detector.update(frame);
+
+    emitFrame(frame);
+}
+
+// Restarts scanning paused by backpressure, changes made meanwhile are caught
+// by the first scan against the last reference frame
+void ZCaptureEngine::autocaptureResumed()
+{
+    if (!m_autocaptureActive || !m_autocapturePaused) return;
+
+    m_autocapturePaused = false;
+    if (m_damageWatcher && m_damageWatcher->isActive()) {
+        autocaptureDamaged();
+    } else {
+        m_autocaptureTimer.start(m_settings.autocaptureInterval);
+        autoCapture();
+    }
+}
+
+void ZCaptureEngine::autocaptureDamaged()
+{
+    if (m_autocapturePaused || m_damageTimer.isActive()) return;
+
+    // damage reports are throttled to the scan interval
+
+    const qint64 interval = m_settings.autocaptureInterval;
+    qint64 delay = 0;
+    if (m_lastAutocaptureTime.isValid())
+        delay = qMax(0LL, interval - m_lastAutocaptureTime.elapsed());
+
+    m_damageTimer.start(static_cast<int>(delay));
+}
+
+void ZCaptureEngine::emitFrame(QImage &frame)
+{
+    // root geometry always starts at the origin, so the clipped rect does too
+    if (m_settings.includePointer)
+        ZXCBTools::blendCursorImage(frame, qMax(m_autocaptureRegion.x(), 0), qMax(m_autocaptureRegion.y(), 0));
+
+    Q_EMIT frameCaptured(frame, m_autocaptureRegion);
+}
+
+void ZCaptureEngine::autocaptureGrabFailed()
+{
+    stopAutocapture();
+    Q_EMIT autocaptureFailed(tr("Unable to make silent capture. XCB error, null snapshot received"));
+}
@@ -0,0 +1,143 @@
+#ifndef CAPTUREENGINE_H
+#define CAPTUREENGINE_H
+
+#include <QObject>
+#include <QImage>
+#include <QPixmap>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include <QTimer>
+#include <QPointer>
+#include <QElapsedTimer>
+
+#include <functional>
+
+#include "encoderqueue.h"
+#include "changedetector.h"
+#include "imageencoder.h"
+
+class ZDamageWatcher;
+
+// Capture orchestration without any widgets: grabbing by mode, file naming,
+// background saving and the autocapture state machine. Everything is driven
+// by the plain ZCaptureSettings struct. The autocapture state is touched by
+// the engine timers only, on the thread the engine lives in.
+class ZCaptureEngine : public QObject
+{
+    Q_OBJECT
+public:
+    enum ZCaptureMode {
+        FullScreen=0,
+        CurrentScreen=1,
+        WindowUnderCursor=2,
+        Region=3
+    };
+    Q_ENUM(ZCaptureMode)
+
+    enum ZAutocaptureState {
+        Watching=0,
+        Settling=1
+    };
+    Q_ENUM(ZAutocaptureState)
+
+    // Receives an asynchronous snapshot, null on failure, and its root-relative area
+    using ZSnapshotCallback = std::function<void(const QPixmap &snapshot, const QRect &region)>;
+
+    struct ZCaptureSettings {
+        ZCaptureMode mode { FullScreen };
+        QRect region;                           // region mode only
+        bool includePointer { false };
+        bool includeDecorations { true };
+
+        QString outputDir;
+        QString fileTemplate;
+        ZImageEncoder::ZEncoderOptions encoder;
+        ZImageEncoder::ZEncoderOptions autocaptureEncoder;
+        int encoderQueueDepth { 8 };
+        ZEncoderQueue::ZOverflowPolicy encoderPolicy { ZEncoderQueue::Block };
+
+        int autocaptureInterval { 1000 };       // ms
+        int autocaptureMaxSettleIntervals { 10 };
+        bool autocaptureWait { true };
+        bool autocaptureStable { false };
+        bool autocaptureDamage { true };
+        int minChangedPixels { 0 };
+        double minChangedTiles { 0.0 };
+        QVector<QRect> ignoreRects;
+    };
+
+private:
+    Q_DISABLE_COPY(ZCaptureEngine)
+
+    ZCaptureSettings m_settings;
+    ZEncoderQueue m_encoderQueue;
+    ZChangeDetector m_detector;
+    ZChangeDetector m_settleDetector;
+    QPointer<ZDamageWatcher> m_damageWatcher;
+    QTimer m_autocaptureTimer;
+    QTimer m_damageTimer;
+    QTimer m_settleTimer;
+    QElapsedTimer m_lastAutocaptureTime;
+    QElapsedTimer m_settleTime;
+    QRect m_autocaptureRegion;
+    ZAutocaptureState m_autocaptureState { Watching };
+    int m_counter { 0 };
+    bool m_autocaptureActive { false };
+    bool m_autocapturePaused { false };
+    bool m_autocaptureGrabbing { false };
+    bool m_autocaptureRescan { false };
+    int m_autocaptureSession { 0 };
+
+    static QRect currentScreenGeometry();
+    void requestAutocaptureFrame(void (ZCaptureEngine::*handler)(QImage &frame));
+    void autocaptureScanned(QImage &frame);
+    void autocaptureSettledFrame(QImage &frame);
+    void emitFrame(QImage &frame);
+    void autocaptureGrabFailed();
+
+public:
+    explicit ZCaptureEngine(QObject *parent = nullptr);
+    ~ZCaptureEngine() override;
+
+    void setSettings(const ZCaptureSettings &settings);
+    const ZCaptureSettings &settings() const;
+    void setCounter(int counter);
+    int counter() const;
+
+    static QPixmap grab(ZCaptureMode mode, const QRect &rect, bool includePointer, bool includeDecorations,
+                        QRect *region);
+    QPixmap grab(QRect *region) const;
+    static void requestGrab(ZCaptureMode mode, const QRect &rect, bool includePointer, bool includeDecorations,
+                            QObject *context, const ZSnapshotCallback &callback);
+
+    static QString generateFileName(int counter, const QString &tmpl, const QSize &size, const QString &dir,
+                                    const QString &extension = QString(), bool withoutPath = true);
+    QString nextFileName(const QSize &size, const QString &extension);
+
+    bool saveAsync(const QImage &image, const QString &fileName, const ZImageEncoder::ZEncoderOptions &options);
+    void waitForDone();
+
+    bool startAutocapture(const QRect &region, bool resetReference = false);
+    void stopAutocapture();
+    bool isAutocaptureActive() const;
+
+private Q_SLOTS:
+    void autoCapture();
+    void autocaptureDamaged();
+    void autocaptureSettled();
+    void autocaptureResumed();
+
+Q_SIGNALS:
+    // The frame is a view into the capture buffer. It stays valid while it is
+    // held, but then the next grab needs new memory, so copy what is kept.
+    void frameCaptured(const QImage &frame, const QRect &region);
+    void autocaptureFailed(const QString &message);
+
+    void saved(const QString &fileName);
+    void saveFailed(const QString &fileName, const QString &error);
+    void dropped(const QString &fileName);
+};
+
+#endif // CAPTUREENGINE_H
@@ -0,0 +1,81 @@
+#include <QDebug>
+
+#include <utility>
+
+#include "captureworker.h"
+#include "framebuffer.h"
+
+ZCaptureWorker::ZCaptureWorker(QObject *parent)
+    : QObject(parent)
+{
+    m_connection = xcb_connect(nullptr, nullptr);
+    int res = xcb_connection_has_error(m_connection);
+    if (res>0) {
+        qCritical() << "Error in XCB capture connection " << res;
+        return;
+    }
+
+    m_frameBuffer.reset(new ZFrameBuffer(m_connection));
+}
+
+ZCaptureWorker::~ZCaptureWorker()
+{
+    m_frameBuffer.reset();
+    xcb_disconnect(m_connection);
+}
+
+bool ZCaptureWorker::isValid() const
+{
+    return !m_frameBuffer.isNull();
+}
+
+QImage ZCaptureWorker::grabWindow(xcb_window_t window)
+{
+    if (!isValid()) return QImage();
+
+    // first get geometry information for our drawable
+
+    xcb_get_geometry_cookie_t geomCookie = xcb_get_geometry_unchecked(m_connection, window);
+    QScopedPointer<xcb_get_geometry_reply_t,QScopedPointerPodDeleter>
+            geomReply(xcb_get_geometry_reply(m_connection, geomCookie, nullptr));
+
+    // then proceed to get an image
+
+    if (geomReply.isNull()) return QImage();
+
+    const QRect geom(geomReply->x, geomReply->y, geomReply->width, geomReply->height);
+    QImage image = m_frameBuffer->grab(window, geom);
+
+    // if the image is null, this means we need to get the root image window
+    // and run a crop
+
+    if (image.isNull() && (window != geomReply->root))
+        return grabWindow(geomReply->root).copy(geom);
+
+    return image;
+}
+
+QImage ZCaptureWorker::grabArea(xcb_drawable_t drawable, const QRect &geometry)
+{
+    if (!isValid()) return QImage();
+
+    return m_frameBuffer->grab(drawable, geometry);
+}
+
+ZCaptureRelay::ZCaptureRelay(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ZCaptureRelay::~ZCaptureRelay() = default;
+
+// Called in the capture thread before captured() is emitted
+void ZCaptureRelay::setImage(QImage image)
+{
+    m_image = std::move(image);
+}
+
+QImage ZCaptureRelay::takeImage()
+{
+    return std::exchange(m_image, QImage());
+}
@@ -0,0 +1,59 @@
+#ifndef CAPTUREWORKER_H
+#define CAPTUREWORKER_H
+
+#include <QObject>
+#include <QImage>
+#include <QRect>
+#include <QScopedPointer>
+
+#include <xcb/xcb.h>
+
+class ZFrameBuffer;
+
+// Serves image grabs on a dedicated thread over a private XCB connection,
+// so large GetImage replies never share the socket with event dispatching.
+// Returned images are views sharing the worker frame buffer memory, see
+// ZFrameBuffer for their lifetime.
+class ZCaptureWorker : public QObject
+{
+    Q_OBJECT
+private:
+    Q_DISABLE_COPY(ZCaptureWorker)
+
+    xcb_connection_t* m_connection { nullptr };
+    QScopedPointer<ZFrameBuffer> m_frameBuffer;
+
+public:
+    explicit ZCaptureWorker(QObject* parent = nullptr);
+    ~ZCaptureWorker() override;
+
+    bool isValid() const;
+    QImage grabWindow(xcb_window_t window);
+    QImage grabArea(xcb_drawable_t drawable, const QRect &geometry);
+
+};
+
+// Carries the result of one queued grab back from the capture thread. The
+// image is handed over through the relay rather than as a signal argument,
+// so the receiver gets the only reference and can paint over it in place.
+class ZCaptureRelay : public QObject
+{
+    Q_OBJECT
+private:
+    Q_DISABLE_COPY(ZCaptureRelay)
+
+    QImage m_image;
+
+public:
+    explicit ZCaptureRelay(QObject* parent = nullptr);
+    ~ZCaptureRelay() override;
+
+    void setImage(QImage image);
+    QImage takeImage();
+
+Q_SIGNALS:
+    void captured();
+
+};
+
+#endif // CAPTUREWORKER_H
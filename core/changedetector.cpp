@@ -0,0 +1,349 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "changedetector.h"
+#include "pixelops.h"
+
+namespace {
+
+// xxHash64 constants and round functions, fed with tile rows as 64-bit words
+const quint64 prime1 = 11400714785074694791ULL;
+const quint64 prime2 = 14029467366897019727ULL;
+const quint64 prime3 = 1609587929392839161ULL;
+const quint64 prime4 = 9650029242287828579ULL;
+const quint64 prime5 = 2870177450012600261ULL;
+
+inline quint64 rotl64(quint64 x, int r)
+{
+    return (x << r) | (x >> (64 - r)); // NOLINT
+}
+
+inline quint64 hashRound(quint64 acc, quint64 input)
+{
+    acc += input * prime2;
+    acc = rotl64(acc, 31); // NOLINT
+    return acc * prime1;
+}
+
+inline quint64 mergeRound(quint64 acc, quint64 val)
+{
+    acc ^= hashRound(0, val);
+    return acc * prime1 + prime4;
+}
+
+inline quint64 readWord(const uchar *p)
+{
+    quint64 res = 0;
+    memcpy(&res, p, sizeof(res));
+    return res;
+}
+
+void feedLanes(quint64 *lanes, const uchar *p, int length)
+{
+    const int stripe = 32;
+    const int word = 8;
+
+    int i = 0;
+    for (; i + stripe <= length; i += stripe) {
+        lanes[0] = hashRound(lanes[0], readWord(p + i));
+        lanes[1] = hashRound(lanes[1], readWord(p + i + word));
+        lanes[2] = hashRound(lanes[2], readWord(p + i + word * 2));
+        lanes[3] = hashRound(lanes[3], readWord(p + i + word * 3));
+    }
+    for (; i + word <= length; i += word)
+        lanes[0] = hashRound(lanes[0], readWord(p + i));
+    if (i < length) {
+        quint64 tail = 0;
+        memcpy(&tail, p + i, static_cast<size_t>(length - i));
+        lanes[1] = hashRound(lanes[1], tail ^ static_cast<quint64>(length - i));
+    }
+}
+
+}
+
+ZChangeDetector::ZChangeDetector(int tileSize)
+    : m_tileSize(qMax(1, tileSize))
+{
+}
+
+void ZChangeDetector::reset()
+{
+    m_hashes.resize(0);
+    m_dirtyTiles.resize(0);
+    m_reference = QImage();
+    m_frameSize = QSize();
+    m_format = QImage::Format_Invalid;
+    m_columns = 0;
+    m_rows = 0;
+}
+
+// Hashes the new frame and compares it tile by tile with the last accepted one.
+// Returns true if the change passes the configured thresholds, then the frame
+// becomes the new reference. Frame size or format change marks all tiles dirty.
+// Sub-byte (mono) frames are expanded to one byte per pixel before hashing, so
+// tiles, ignore rects and the changed pixel counter work the same for them.
+bool ZChangeDetector::update(const QImage &image)
+{
+    const int bitsPerByte = 8;
+
+    if (image.isNull()) return false;
+
+    const QImage frame = (image.depth() < bitsPerByte) ? image.convertToFormat(QImage::Format_Indexed8) : image;
+
+    const bool force = ((frame.size() != m_frameSize) || (frame.format() != m_format) ||
+                        m_hashes.isEmpty());
+    if (force) {
+        m_frameSize = frame.size();
+        m_format = frame.format();
+        m_columns = (m_frameSize.width() + m_tileSize - 1) / m_tileSize;
+        m_rows = (m_frameSize.height() + m_tileSize - 1) / m_tileSize;
+        m_hashes.resize(m_columns * m_rows);
+        m_newHashes.resize(m_columns * m_rows);
+        m_states.resize(m_columns);
+    }
+
+    m_dirtyTiles.resize(0);
+    for (int tileRow = 0; tileRow < m_rows; tileRow++)
+        hashTileRow(frame, tileRow, force);
+
+    if (m_dirtyTiles.isEmpty()) return false;
+    if (!force && !isAboveThreshold(frame)) return false;
+
+    std::swap(m_hashes, m_newHashes);
+    if (m_minChangedPixels > 0)
+        updateReference(frame, force);
+
+    return true;
+}
+
+void ZChangeDetector::setMinChangedPixels(int pixels)
+{
+    m_minChangedPixels = qMax(0, pixels);
+    if (m_minChangedPixels == 0)
+        m_reference = QImage();
+}
+
+void ZChangeDetector::setMinChangedTiles(double fraction)
+{
+    m_minChangedTiles = qBound(0.0, fraction, 1.0);
+}
+
+// Ignore rects are frame-relative. Pixels inside them never count as changes.
+void ZChangeDetector::setIgnoreRects(const QVector<QRect> &rects)
+{
+    if (rects == m_ignoreRects) return;
+
+    m_ignoreRects = rects;
+    reset();
+}
+
+void ZChangeDetector::hashTileRow(const QImage &frame, int tileRow, bool force)
+{
+    const int bitsPerByte = 8;
+
+    const int bytesPerPixel = frame.depth() / bitsPerByte;
+    const int tileBytes = m_tileSize * bytesPerPixel;
+    const int lineBytes = m_frameSize.width() * bytesPerPixel;
+    const bool useSpans = !m_ignoreRects.isEmpty();
+
+    for (auto &state : m_states) {
+        state.lanes[0] = prime1 + prime2;
+        state.lanes[1] = prime2;
+        state.lanes[2] = 0;
+        state.lanes[3] = 0 - prime1;
+    }
+
+    const int top = tileRow * m_tileSize;
+    const int bottom = qMin(top + m_tileSize, m_frameSize.height());
+    for (int y = top; y < bottom; y++) {
+        const uchar *line = frame.constScanLine(y);
+
+        if (!useSpans) {
+            for (int col = 0; col < m_columns; col++) {
+                feedLanes(m_states[col].lanes, line + col * tileBytes,
+                          qMin(tileBytes, lineBytes - col * tileBytes));
+            }
+            continue;
+        }
+
+        // feed only the pixels outside of ignore rects, split by tiles
+        visibleSpans(y, 0, m_frameSize.width());
+        for (const auto &span : std::as_const(m_spans)) {
+            int x = span.first;
+            while (x < span.second) {
+                const int col = x / m_tileSize;
+                const int end = qMin(span.second, (col + 1) * m_tileSize);
+                feedLanes(m_states[col].lanes, line + x * bytesPerPixel, (end - x) * bytesPerPixel);
+                x = end;
+            }
+        }
+    }
+
+    for (int col = 0; col < m_columns; col++) {
+        const quint64 *lanes = m_states.at(col).lanes;
+        quint64 h = rotl64(lanes[0], 1) + rotl64(lanes[1], 7) + rotl64(lanes[2], 12) + rotl64(lanes[3], 18); // NOLINT
+        h = mergeRound(h, lanes[0]);
+        h = mergeRound(h, lanes[1]);
+        h = mergeRound(h, lanes[2]);
+        h = mergeRound(h, lanes[3]);
+        h += prime5;
+
+        // avalanche
+        h ^= h >> 33; // NOLINT
+        h *= prime2;
+        h ^= h >> 29; // NOLINT
+        h *= prime3;
+        h ^= h >> 32; // NOLINT
+
+        const int index = tileRow * m_columns + col;
+        m_newHashes[index] = h;
+        if (force || m_hashes.at(index) != h)
+            m_dirtyTiles.append(index);
+    }
+}
+
+// Fills m_spans with [start, end) pixel intervals of the scanline y,
+// that are not covered by any ignore rect
+void ZChangeDetector::visibleSpans(int y, int left, int right)
+{
+    m_spans.resize(0);
+    m_ignoreSpans.resize(0);
+
+    for (const auto &rect : std::as_const(m_ignoreRects)) {
+        if (y < rect.top() || y > rect.bottom()) continue;
+
+        const int start = qMax(rect.left(), left);
+        const int end = qMin(rect.right() + 1, right);
+        if (start < end)
+            m_ignoreSpans.append(qMakePair(start, end));
+    }
+
+    std::sort(m_ignoreSpans.begin(), m_ignoreSpans.end());
+
+    int x = left;
+    for (const auto &span : std::as_const(m_ignoreSpans)) {
+        if (span.first > x)
+            m_spans.append(qMakePair(x, span.first));
+        x = qMax(x, span.second);
+    }
+    if (x < right)
+        m_spans.append(qMakePair(x, right));
+}
+
+bool ZChangeDetector::isAboveThreshold(const QImage &frame)
+{
+    if (m_minChangedTiles > 0.0) {
+        const auto minTiles = static_cast<int>(std::ceil(m_minChangedTiles * tileCount()));
+        if (m_dirtyTiles.count() < minTiles)
+            return false;
+    }
+
+    if ((m_minChangedPixels > 0) && (m_reference.size() == frame.size()) &&
+            (m_reference.format() == frame.format())) {
+        int changed = 0;
+        for (const int index : std::as_const(m_dirtyTiles)) {
+            changed += countTileChanges(frame, index);
+            if (changed >= m_minChangedPixels)
+                return true;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+int ZChangeDetector::countTileChanges(const QImage &frame, int index)
+{
+    const int bitsPerByte = 8;
+    const int rgbDepth = 32;
+
+    const QRect tile = tileRect(index);
+    const int bytesPerPixel = frame.depth() / bitsPerByte;
+
+    int res = 0;
+    for (int y = tile.top(); y <= tile.bottom(); y++) {
+        const uchar *line = frame.constScanLine(y);
+        const uchar *refLine = m_reference.constScanLine(y);
+
+        visibleSpans(y, tile.left(), tile.right() + 1);
+        for (const auto &span : std::as_const(m_spans)) {
+            const int length = span.second - span.first;
+            if (frame.depth() == rgbDepth) {
+                res += static_cast<int>(ZPixelOps::countChangedPixels(
+                                            reinterpret_cast<const quint32 *>(line) + span.first,
+                                            reinterpret_cast<const quint32 *>(refLine) + span.first,
+                                            static_cast<quint32>(length)));
+            } else {
+                for (int x = span.first; x < span.second; x++) {
+                    if (memcmp(line + x * bytesPerPixel, refLine + x * bytesPerPixel,
+                               static_cast<size_t>(bytesPerPixel)) != 0)
+                        res++;
+                }
+            }
+        }
+    }
+
+    return res;
+}
+
+// Keeps the pixels of the accepted frame for the changed pixel counter.
+// Only the dirty tiles are copied, the storage is reused.
+void ZChangeDetector::updateReference(const QImage &frame, bool force)
+{
+    const int bitsPerByte = 8;
+
+    if (force || (m_reference.size() != frame.size()) || (m_reference.format() != frame.format())) {
+        m_reference = frame.copy();
+        return;
+    }
+
+    const int bytesPerPixel = frame.depth() / bitsPerByte;
+    for (const int index : std::as_const(m_dirtyTiles)) {
+        const QRect tile = tileRect(index);
+        const auto length = static_cast<size_t>(tile.width() * bytesPerPixel);
+        for (int y = tile.top(); y <= tile.bottom(); y++) {
+            memcpy(m_reference.scanLine(y) + tile.left() * bytesPerPixel,
+                   frame.constScanLine(y) + tile.left() * bytesPerPixel, length);
+        }
+    }
+}
+
+int ZChangeDetector::tileSize() const
+{
+    return m_tileSize;
+}
+
+int ZChangeDetector::tileCount() const
+{
+    return m_hashes.count();
+}
+
+const QVector<quint64> &ZChangeDetector::hashes() const
+{
+    return m_hashes;
+}
+
+const QVector<int> &ZChangeDetector::dirtyTiles() const
+{
+    return m_dirtyTiles;
+}
+
+QRect ZChangeDetector::tileRect(int index) const
+{
+    if (m_columns <= 0) return QRect();
+
+    const int col = index % m_columns;
+    const int row = index / m_columns;
+    const QRect tile(col * m_tileSize, row * m_tileSize, m_tileSize, m_tileSize);
+    return tile.intersected(QRect(QPoint(0, 0), m_frameSize));
+}
+
+// Bounding rect of the tiles changed by the last update
+QRect ZChangeDetector::dirtyRect() const
+{
+    QRect res;
+    for (const int index : m_dirtyTiles)
+        res = res.united(tileRect(index));
+    return res;
+}
@@ -0,0 +1,65 @@
+#ifndef CHANGEDETECTOR_H
+#define CHANGEDETECTOR_H
+
+#include <QImage>
+#include <QRect>
+#include <QPair>
+#include <QVector>
+
+// Detects frame changes by comparing per-tile hashes with the last accepted frame.
+// Only the hash vector is kept between frames (plus the reference pixels when a
+// changed pixel threshold is set), and the changed tiles are reported so later
+// stages can process the dirty area only.
+class ZChangeDetector
+{
+public:
+    static const int defaultTileSize = 64;
+
+private:
+    using ZSpan = QPair<int, int>;
+
+    struct ZTileHashState {
+        quint64 lanes[4];
+    };
+
+    QVector<quint64> m_hashes;
+    QVector<quint64> m_newHashes;
+    QVector<ZTileHashState> m_states;
+    QVector<int> m_dirtyTiles;
+    QVector<QRect> m_ignoreRects;
+    QVector<ZSpan> m_spans;
+    QVector<ZSpan> m_ignoreSpans;
+    QImage m_reference;
+    QSize m_frameSize;
+    QImage::Format m_format { QImage::Format_Invalid };
+    int m_tileSize { defaultTileSize };
+    int m_columns { 0 };
+    int m_rows { 0 };
+    int m_minChangedPixels { 0 };
+    double m_minChangedTiles { 0.0 };
+
+    void hashTileRow(const QImage &frame, int tileRow, bool force);
+    void visibleSpans(int y, int left, int right);
+    bool isAboveThreshold(const QImage &frame);
+    int countTileChanges(const QImage &frame, int index);
+    void updateReference(const QImage &frame, bool force);
+
+public:
+    explicit ZChangeDetector(int tileSize = defaultTileSize);
+
+    void reset();
+    bool update(const QImage &image);
+
+    void setMinChangedPixels(int pixels);
+    void setMinChangedTiles(double fraction);
+    void setIgnoreRects(const QVector<QRect> &rects);
+
+    int tileSize() const;
+    int tileCount() const;
+    const QVector<quint64> &hashes() const;
+    const QVector<int> &dirtyTiles() const;
+    QRect tileRect(int index) const;
+    QRect dirtyRect() const;
+};
+
+#endif // CHANGEDETECTOR_H
@@ -0,0 +1,43 @@
+include(../scrcap.pri)
+
+TARGET = scrcapcore
+TEMPLATE = lib
+
+CONFIG += staticlib
+
+SOURCES += \
+    xcbtools.cpp \
+    framebuffer.cpp \
+    captureworker.cpp \
+    windowtree.cpp \
+    windowindex.cpp \
+    cursorcache.cpp \
+    keysymcache.cpp \
+    damagewatcher.cpp \
+    encoderqueue.cpp \
+    pixelops.cpp \
+    changedetector.cpp \
+    animationwriter.cpp \
+    pngwriter.cpp \
+    imageencoder.cpp \
+    gstrecorder.cpp \
+    captureengine.cpp
+
+HEADERS += \
+    coredefs.h \
+    xcbtools.h \
+    framebuffer.h \
+    captureworker.h \
+    windowtree.h \
+    windowindex.h \
+    cursorcache.h \
+    keysymcache.h \
+    damagewatcher.h \
+    encoderqueue.h \
+    pixelops.h \
+    changedetector.h \
+    animationwriter.h \
+    pngwriter.h \
+    imageencoder.h \
+    gstrecorder.h \
+    captureengine.h
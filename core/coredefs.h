@@ -0,0 +1,8 @@
+#ifndef COREDEFS_H
+#define COREDEFS_H
+
+#include <QString>
+
+#define QSL QStringLiteral
+
+#endif // COREDEFS_H
@@ -0,0 +1,74 @@
+#include <QMutexLocker>
+#include <QDebug>
+
+#include "cursorcache.h"
+
+ZCursorCache::ZCursorCache(quint8 xfixesEventBase, QObject *parent)
+    : ZAbstractXCBEventListener(parent)
+{
+    // without notifications the cursor image is fetched for each grab
+    if (xfixesEventBase == 0) return;
+
+    xcb_connection_t* c = ZXCBTools::connection(ZXCBTools::instance());
+
+    ZXCBTools::addEventListener(this, static_cast<quint8>(xfixesEventBase + XCB_XFIXES_CURSOR_NOTIFY));
+
+    const xcb_setup_t *setup = xcb_get_setup(c);
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(setup);
+    while (it.rem>0) {
+        xcb_xfixes_select_cursor_input(c, it.data->root, XCB_XFIXES_CURSOR_NOTIFY_MASK_DISPLAY_CURSOR);
+        xcb_screen_next(&it);
+    }
+    xcb_flush(c);
+
+    m_notifyActive = true;
+}
+
+ZCursorCache::~ZCursorCache()
+{
+    if (m_notifyActive)
+        ZXCBTools::removeEventListener(this);
+}
+
+bool ZCursorCache::cursorImage(QImage *image, QPoint *hotspot)
+{
+    QMutexLocker locker(&m_cursorMutex);
+
+    // mark valid before the request, so a notification received
+    // while we are waiting for the reply invalidates it again
+    if (!m_notifyActive || m_valid.fetchAndStoreOrdered(1) == 0) {
+        xcb_connection_t *c = ZXCBTools::connection(ZXCBTools::instance());
+
+        xcb_xfixes_get_cursor_image_cookie_t cursorCookie = xcb_xfixes_get_cursor_image_unchecked(c);
+        QScopedPointer<xcb_xfixes_get_cursor_image_reply_t,QScopedPointerPodDeleter>
+                cursorReply(xcb_xfixes_get_cursor_image_reply(c, cursorCookie, nullptr));
+
+        quint32 *pixelData = nullptr;
+        if (cursorReply)
+            pixelData = xcb_xfixes_get_cursor_image_cursor_image(cursorReply.data());
+
+        if (pixelData == nullptr) {
+            m_valid.storeRelease(0);
+            m_image = QImage();
+            return false;
+        }
+
+        m_image = QImage(reinterpret_cast<quint8 *>(pixelData),
+                         cursorReply->width, cursorReply->height,
+                         QImage::Format_ARGB32_Premultiplied).copy();
+        m_hotspot = QPoint(cursorReply->xhot, cursorReply->yhot);
+    }
+
+    if (m_image.isNull()) return false;
+
+    *image = m_image;
+    *hotspot = m_hotspot;
+    return true;
+}
+
+void ZCursorCache::nativeEventHandler(const xcb_generic_event_t *event)
+{
+    Q_UNUSED(event)
+
+    m_valid.storeRelease(0);
+}
@@ -0,0 +1,37 @@
+#ifndef CURSORCACHE_H
+#define CURSORCACHE_H
+
+#include <QObject>
+#include <QImage>
+#include <QPoint>
+#include <QMutex>
+#include <QAtomicInt>
+
+#include "xcbtools.h"
+
+// Keeps the last XFixes cursor image. The image is refetched only after
+// the X server reports a cursor change with CursorNotify event.
+class ZCursorCache : public ZAbstractXCBEventListener
+{
+    Q_OBJECT
+private:
+    Q_DISABLE_COPY(ZCursorCache)
+
+    QMutex m_cursorMutex;
+    QImage m_image;
+    QPoint m_hotspot;
+    QAtomicInt m_valid { 0 };
+    bool m_notifyActive { false };
+
+public:
+    ZCursorCache(quint8 xfixesEventBase, QObject* parent = nullptr);
+    ~ZCursorCache() override;
+
+    bool cursorImage(QImage *image, QPoint *hotspot);
+
+protected:
+    void nativeEventHandler(const xcb_generic_event_t* event) override;
+
+};
+
+#endif // CURSORCACHE_H
@@ -0,0 +1,76 @@
+#include <QMutexLocker>
+#include <QDebug>
+
+#include "damagewatcher.h"
+
+ZDamageWatcher::ZDamageWatcher(QObject *parent)
+    : ZAbstractXCBEventListener(parent)
+{
+    if (!isDamageSupported()) return;
+
+    xcb_connection_t* c = ZXCBTools::connection(ZXCBTools::instance());
+
+    m_damage = xcb_generate_id(c);
+    xcb_void_cookie_t vc = xcb_damage_create_checked(c, m_damage, ZXCBTools::appRootWindow(),
+                                                     XCB_DAMAGE_REPORT_LEVEL_RAW_RECTANGLES);
+    QScopedPointer<xcb_generic_error_t,QScopedPointerPodDeleter> err(xcb_request_check(c, vc));
+    if (err) {
+        qWarning() << "Unable to create XDamage object for root window";
+        m_damage = 0;
+        return;
+    }
+
+    ZXCBTools::addEventListener(this, static_cast<quint8>(ZXCBTools::damageEventBase() + XCB_DAMAGE_NOTIFY));
+}
+
+ZDamageWatcher::~ZDamageWatcher()
+{
+    if (m_damage == 0) return;
+
+    ZXCBTools::removeEventListener(this);
+
+    xcb_connection_t* c = ZXCBTools::connection(ZXCBTools::instance());
+    xcb_damage_destroy(c, m_damage);
+    xcb_flush(c);
+}
+
+bool ZDamageWatcher::isDamageSupported()
+{
+    return (ZXCBTools::damageEventBase() > 0);
+}
+
+bool ZDamageWatcher::isActive() const
+{
+    return (m_damage != 0);
+}
+
+void ZDamageWatcher::setWatchRegion(const QRect &region)
+{
+    QMutexLocker locker(&m_regionMutex);
+    m_watchRegion = region;
+}
+
+void ZDamageWatcher::acknowledge()
+{
+    m_pending.storeRelease(0);
+}
+
+void ZDamageWatcher::nativeEventHandler(const xcb_generic_event_t *event)
+{
+    const auto *dev = reinterpret_cast<const xcb_damage_notify_event_t *>(event);
+
+    if ((dev == nullptr) || (dev->damage != m_damage)) return;
+
+    const QRect area(dev->area.x, dev->area.y, dev->area.width, dev->area.height);
+    {
+        QMutexLocker locker(&m_regionMutex);
+        if (!m_watchRegion.intersects(area)) return;
+    }
+
+    // one queued notification at a time, the rest is coalesced into it
+    if (m_pending.testAndSetOrdered(0, 1)) {
+        QMetaObject::invokeMethod(this,[this](){
+            Q_EMIT regionDamaged();
+        },Qt::QueuedConnection);
+    }
+}
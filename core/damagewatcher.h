@@ -0,0 +1,42 @@
+#ifndef DAMAGEWATCHER_H
+#define DAMAGEWATCHER_H
+
+#include <QObject>
+#include <QRect>
+#include <QMutex>
+#include <QAtomicInt>
+
+#include "xcbtools.h"
+
+// Watches XDamage reports for the root window and signals when any damaged
+// rectangle intersects the watched region. Notifications are coalesced until
+// the receiver calls acknowledge().
+class ZDamageWatcher : public ZAbstractXCBEventListener
+{
+    Q_OBJECT
+private:
+    Q_DISABLE_COPY(ZDamageWatcher)
+
+    QMutex m_regionMutex;
+    QRect m_watchRegion;
+    QAtomicInt m_pending { 0 };
+    xcb_damage_damage_t m_damage { 0 };
+
+public:
+    explicit ZDamageWatcher(QObject* parent = nullptr);
+    ~ZDamageWatcher() override;
+
+    static bool isDamageSupported();
+    bool isActive() const;
+    void setWatchRegion(const QRect &region);
+    void acknowledge();
+
+Q_SIGNALS:
+    void regionDamaged();
+
+protected:
+    void nativeEventHandler(const xcb_generic_event_t* event) override;
+
+};
+
+#endif // DAMAGEWATCHER_H
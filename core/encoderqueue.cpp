@@ -0,0 +1,119 @@
+#include <QMutexLocker>
+#include <QStringList>
+#include <QThread>
+#include <QDebug>
+
+#include "encoderqueue.h"
+
+ZEncoderQueue::ZEncoderQueue(QObject *parent)
+    : QObject(parent)
+{
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+}
+
+ZEncoderQueue::~ZEncoderQueue()
+{
+    waitForDone();
+}
+
+void ZEncoderQueue::setMaxDepth(int depth)
+{
+    QMutexLocker locker(&m_queueMutex);
+    m_maxDepth = qMax(1, depth);
+    m_queueNotFull.wakeAll();
+}
+
+void ZEncoderQueue::setPolicy(ZEncoderQueue::ZOverflowPolicy policy)
+{
+    QMutexLocker locker(&m_queueMutex);
+    m_policy = policy;
+    m_queueNotFull.wakeAll();
+}
+
+int ZEncoderQueue::pendingCount()
+{
+    QMutexLocker locker(&m_queueMutex);
+    return m_jobs.count();
+}
+
+bool ZEncoderQueue::isFull()
+{
+    QMutexLocker locker(&m_queueMutex);
+    return m_jobs.count() >= m_maxDepth;
+}
+
+// Returns false if the new job was dropped by the overflow policy
+bool ZEncoderQueue::enqueue(const QImage &image, const QString &fileName,
+                            const ZImageEncoder::ZEncoderOptions &options)
+{
+    if (image.isNull() || fileName.isEmpty()) return false;
+
+    QStringList droppedFiles;
+    bool accepted = true;
+    {
+        QMutexLocker locker(&m_queueMutex);
+
+        while (m_jobs.count() >= m_maxDepth) {
+            if (m_policy == DropNewest) {
+                droppedFiles.append(fileName);
+                accepted = false;
+                break;
+            }
+
+            if (m_policy == DropOldest) {
+                droppedFiles.append(m_jobs.dequeue().fileName);
+                continue;
+            }
+
+            // backpressure, wait for a worker to take the job. Blocking the owner
+            // thread would freeze its event loop, the job is taken over the limit there
+            if (QThread::currentThread() == thread()) break;
+
+            m_queueNotFull.wait(&m_queueMutex);
+        }
+
+        if (accepted)
+            m_jobs.enqueue({ image, fileName, options });
+    }
+
+    for (const auto &file : std::as_const(droppedFiles))
+        Q_EMIT dropped(file);
+
+    if (!accepted) return false;
+
+    // one worker task per job, a task for the dropped job finds the queue empty
+    m_pool.start([this](){
+        processNextJob();
+    });
+
+    return true;
+}
+
+void ZEncoderQueue::waitForDone()
+{
+    m_pool.waitForDone();
+}
+
+void ZEncoderQueue::processNextJob()
+{
+    ZEncoderJob job;
+    bool gotRoom = false;
+    {
+        QMutexLocker locker(&m_queueMutex);
+        if (m_jobs.isEmpty()) return;
+        job = m_jobs.dequeue();
+        gotRoom = (m_jobs.count() == m_maxDepth - 1);
+        m_queueNotFull.wakeOne();
+    }
+
+    if (gotRoom)
+        Q_EMIT drained();
+
+    QString error;
+    if (!ZImageEncoder::encode(job.image, job.fileName, job.options, &error)) {
+        Q_EMIT failed(job.fileName, error);
+        return;
+    }
+
+    Q_EMIT saved(job.fileName);
+}
@@ -0,0 +1,66 @@
+#ifndef ENCODERQUEUE_H
+#define ENCODERQUEUE_H
+
+#include <QObject>
+#include <QImage>
+#include <QString>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+
+#include "imageencoder.h"
+
+// Bounded background queue for image encoding and saving. Jobs are served by a
+// thread pool, results are reported with signals (queued to the receiver thread).
+// The Block policy never waits on the thread owning the queue (usually the GUI
+// or engine thread): its producers check isFull() and resume on drained().
+class ZEncoderQueue : public QObject
+{
+    Q_OBJECT
+public:
+    enum ZOverflowPolicy {
+        Block=0,
+        DropNewest=1,
+        DropOldest=2
+    };
+    Q_ENUM(ZOverflowPolicy)
+
+private:
+    struct ZEncoderJob {
+        QImage image;
+        QString fileName;
+        ZImageEncoder::ZEncoderOptions options;
+    };
+
+    Q_DISABLE_COPY(ZEncoderQueue)
+
+    QMutex m_queueMutex;
+    QWaitCondition m_queueNotFull;
+    QQueue<ZEncoderJob> m_jobs;
+    QThreadPool m_pool;
+    int m_maxDepth { 8 };
+    ZOverflowPolicy m_policy { Block };
+
+    void processNextJob();
+
+public:
+    explicit ZEncoderQueue(QObject *parent = nullptr);
+    ~ZEncoderQueue() override;
+
+    void setMaxDepth(int depth);
+    void setPolicy(ZOverflowPolicy policy);
+    int pendingCount();
+    bool isFull();
+
+    bool enqueue(const QImage &image, const QString &fileName, const ZImageEncoder::ZEncoderOptions &options);
+    void waitForDone();
+
+Q_SIGNALS:
+    void saved(const QString &fileName);
+    void failed(const QString &fileName, const QString &error);
+    void dropped(const QString &fileName);
+    void drained();
+};
+
+#endif // ENCODERQUEUE_H
@@ -0,0 +1,252 @@
+#include <QScopedPointer>
+#include <QColor>
+#include <QDebug>
+
+#include <cstring>
+
+extern "C" {
+#include <sys/ipc.h>
+#include <sys/shm.h>
+}
+
+#include "framebuffer.h"
+#include "pixelops.h"
+
+ZFrameBuffer::ZFrameBuffer(xcb_connection_t *connection, bool useShm)
+    : m_connection(connection)
+{
+    if (useShm)
+        initShm();
+}
+
+// Views still alive keep their blocks, the last one frees the memory
+ZFrameBuffer::~ZFrameBuffer()
+{
+    releaseShm();
+    if (m_heapBlock != nullptr)
+        releaseBlock(m_heapBlock);
+}
+
+bool ZFrameBuffer::isShmSupported() const
+{
+    return m_shmSupported;
+}
+
+void ZFrameBuffer::initShm()
+{
+    const xcb_query_extension_reply_t* ext = xcb_get_extension_data(m_connection, &xcb_shm_id);
+    if ((ext == nullptr) || (ext->present == 0U)) {
+        qInfo() << "XCB MIT-SHM extension not available, using socket image transfer";
+        return;
+    }
+
+    xcb_shm_query_version_cookie_t vc = xcb_shm_query_version(m_connection);
+    QScopedPointer<xcb_shm_query_version_reply_t,QScopedPointerPodDeleter>
+            vr(xcb_shm_query_version_reply(m_connection, vc, nullptr));
+
+    m_shmSupported = !vr.isNull();
+}
+
+quint32 ZFrameBuffer::rootSize() const
+{
+    quint32 res = 0;
+    const xcb_setup_t *setup = xcb_get_setup(m_connection);
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(setup);
+
+    while (it.rem>0) {
+        res = qMax(res, static_cast<quint32>(it.data->width_in_pixels * it.data->height_in_pixels * 4));
+        xcb_screen_next(&it);
+    }
+
+    return res;
+}
+
+// Only the frame buffer holds the block, so no view can see it being rewritten
+bool ZFrameBuffer::isReusable(ZFrameBlock *block, quint32 size)
+{
+    return (block != nullptr) && (size <= block->size) && (block->refs.loadAcquire() == 1);
+}
+
+// QImage cleanup function, drops one reference to the block
+void ZFrameBuffer::releaseBlock(void *block)
+{
+    auto* b = static_cast<ZFrameBlock *>(block);
+    if (b->refs.deref()) return;
+
+    if (b->shm) {
+        shmdt(b->data);
+    } else {
+        delete[] b->data;
+    }
+    delete b;
+}
+
+// Keeps one persistent shared segment per connection. The segment is sized
+// to the root window at least, so the regular grabs never reallocate it.
+// A segment still wrapped by a view is left to that view and replaced.
+bool ZFrameBuffer::ensureShmSegment(quint32 size)
+{
+    const int shmPermissions = 0600;
+
+    if (!m_shmSupported) return false;
+    if (isReusable(m_shmBlock, size)) return true;
+
+    releaseShm();
+
+    const quint32 allocSize = qMax(size, rootSize());
+
+    const int shmId = shmget(IPC_PRIVATE, allocSize, IPC_CREAT | shmPermissions);
+    if (shmId < 0) {
+        qWarning() << "Unable to allocate shared memory segment, MIT-SHM disabled";
+        m_shmSupported = false;
+        return false;
+    }
+
+    void* addr = shmat(shmId, nullptr, 0);
+    if (addr == reinterpret_cast<void *>(-1)) { // NOLINT
+        qWarning() << "Unable to attach shared memory segment, MIT-SHM disabled";
+        shmctl(shmId, IPC_RMID, nullptr);
+        m_shmSupported = false;
+        return false;
+    }
+
+    m_shmSeg = xcb_generate_id(m_connection);
+    xcb_void_cookie_t ac = xcb_shm_attach_checked(m_connection, m_shmSeg, static_cast<quint32>(shmId), 0);
+    QScopedPointer<xcb_generic_error_t,QScopedPointerPodDeleter> err(xcb_request_check(m_connection, ac));
+
+    // the segment will be destroyed after the last detach, both ours and X server side
+    shmctl(shmId, IPC_RMID, nullptr);
+
+    if (err) {
+        // remote X server, most likely
+        qWarning() << "X server unable to attach shared memory segment, MIT-SHM disabled";
+        shmdt(addr);
+        m_shmSeg = 0;
+        m_shmSupported = false;
+        return false;
+    }
+
+    m_shmBlock = new ZFrameBlock();
+    m_shmBlock->data = reinterpret_cast<quint8 *>(addr);
+    m_shmBlock->size = allocSize;
+    m_shmBlock->shm = true;
+
+    return true;
+}
+
+// Detaches the server side at once, our mapping goes away with the last view
+void ZFrameBuffer::releaseShm()
+{
+    if (m_shmSeg != 0) {
+        xcb_shm_detach(m_connection, m_shmSeg);
+        xcb_flush(m_connection);
+        m_shmSeg = 0;
+    }
+    if (m_shmBlock != nullptr) {
+        releaseBlock(m_shmBlock);
+        m_shmBlock = nullptr;
+    }
+}
+
+void ZFrameBuffer::ensureHeapBlock(quint32 size)
+{
+    if (isReusable(m_heapBlock, size)) return;
+
+    if (m_heapBlock != nullptr)
+        releaseBlock(m_heapBlock);
+
+    m_heapBlock = new ZFrameBlock();
+    m_heapBlock->data = new quint8[size];
+    m_heapBlock->size = size;
+}
+
+QImage ZFrameBuffer::grab(xcb_drawable_t drawable, const QRect &geometry)
+{
+    if (geometry.isEmpty()) return QImage();
+
+    // try zero-copy transfer through shared memory first
+    // 32 bits per pixel is the worst case for all supported depths
+
+    const auto size = static_cast<quint32>(geometry.width() * geometry.height() * 4);
+    if (ensureShmSegment(size)) {
+        xcb_shm_get_image_cookie_t ic = xcb_shm_get_image_unchecked(m_connection,
+                                                                    drawable,
+                                                                    static_cast<int16_t>(geometry.x()),
+                                                                    static_cast<int16_t>(geometry.y()),
+                                                                    static_cast<uint16_t>(geometry.width()),
+                                                                    static_cast<uint16_t>(geometry.height()),
+                                                                    ~0U,
+                                                                    XCB_IMAGE_FORMAT_Z_PIXMAP,
+                                                                    m_shmSeg,
+                                                                    0);
+        QScopedPointer<xcb_shm_get_image_reply_t,QScopedPointerPodDeleter>
+                ir(xcb_shm_get_image_reply(m_connection, ic, nullptr));
+
+        if (ir)
+            return wrapNative(ir->depth, geometry.width(), geometry.height(), m_shmBlock, ir->size);
+    }
+
+    // then fall back to socket transfer into the reusable heap block
+
+    xcb_get_image_cookie_t ic = xcb_get_image_unchecked(m_connection,
+                                                        XCB_IMAGE_FORMAT_Z_PIXMAP,
+                                                        drawable,
+                                                        static_cast<int16_t>(geometry.x()),
+                                                        static_cast<int16_t>(geometry.y()),
+                                                        static_cast<uint16_t>(geometry.width()),
+                                                        static_cast<uint16_t>(geometry.height()),
+                                                        ~0U);
+    QScopedPointer<xcb_get_image_reply_t,QScopedPointerPodDeleter>
+            ir(xcb_get_image_reply(m_connection, ic, nullptr));
+
+    if (ir.isNull()) return QImage();
+
+    const auto length = static_cast<quint32>(xcb_get_image_data_length(ir.data()));
+    ensureHeapBlock(length);
+    memcpy(m_heapBlock->data, xcb_get_image_data(ir.data()), length);
+
+    return wrapNative(ir->depth, geometry.width(), geometry.height(), m_heapBlock, length);
+}
+
+QImage ZFrameBuffer::wrapNative(quint8 depth, int width, int height, ZFrameBlock *block, quint32 size)
+{
+    QImage::Format format = QImage::Format_Invalid;
+
+    switch (depth) {
+        case 1:
+            format = QImage::Format_MonoLSB;
+            break;
+        case 16: // NOLINT
+            format = QImage::Format_RGB16;
+            break;
+        case 24: // NOLINT
+            format = QImage::Format_RGB32;
+            break;
+        case 30: // NOLINT
+            // Qt doesn't have a matching image format. We need to convert manually
+            ZPixelOps::convertDepth30(reinterpret_cast<quint32 *>(block->data), size / 4);
+            // fall through, Qt format is still Format_ARGB32_Premultiplied
+            [[clang::fallthrough]];
+        case 32: // NOLINT
+            format = QImage::Format_ARGB32_Premultiplied;
+            break;
+        default:
+            return QImage(); // we don't know
+    }
+
+    // the view holds a reference until its last copy is gone
+
+    const int bytesPerLine = static_cast<int>(size) / height;
+    block->refs.ref();
+    QImage view(block->data, width, height, bytesPerLine, format, releaseBlock, block);
+
+    // work around an abort in QImage::color
+
+    if (view.format() == QImage::Format_MonoLSB) {
+        view.setColorCount(2);
+        view.setColor(0, QColor(Qt::white).rgb());
+        view.setColor(1, QColor(Qt::black).rgb());
+    }
+
+    return view;
+}
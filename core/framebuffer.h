@@ -0,0 +1,55 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <QAtomicInt>
+#include <QImage>
+#include <QRect>
+
+#include <xcb/xcb.h>
+#include <xcb/shm.h>
+
+// Capture memory, an attached MIT-SHM segment or a heap block. The frame buffer
+// and every image wrapping the block hold one reference each.
+struct ZFrameBlock
+{
+    quint8* data { nullptr };
+    quint32 size { 0 };
+    bool shm { false };
+    QAtomicInt refs { 1 };
+};
+
+// Persistent capture buffer bound to one XCB connection. Grabs are written
+// into a reusable MIT-SHM segment (or a reusable heap block when SHM is not
+// available) and returned as QImage views sharing that block. A block is
+// written again only after all its views are gone, otherwise the next grab
+// gets a fresh one, so views stay valid on any thread for as long as they live.
+class ZFrameBuffer
+{
+private:
+    Q_DISABLE_COPY(ZFrameBuffer)
+
+    xcb_connection_t* m_connection { nullptr };
+    xcb_shm_seg_t m_shmSeg { 0 };
+    ZFrameBlock* m_shmBlock { nullptr };
+    ZFrameBlock* m_heapBlock { nullptr };
+    bool m_shmSupported { false };
+
+    void initShm();
+    bool ensureShmSegment(quint32 size);
+    void releaseShm();
+    void ensureHeapBlock(quint32 size);
+    quint32 rootSize() const;
+    QImage wrapNative(quint8 depth, int width, int height, ZFrameBlock *block, quint32 size);
+
+    static bool isReusable(ZFrameBlock *block, quint32 size);
+    static void releaseBlock(void *block);
+
+public:
+    explicit ZFrameBuffer(xcb_connection_t* connection, bool useShm = true);
+    ~ZFrameBuffer();
+
+    bool isShmSupported() const;
+    QImage grab(xcb_drawable_t drawable, const QRect &geometry);
+};
+
+#endif // FRAMEBUFFER_H
@@ -0,0 +1,301 @@
+#include <QFile>
+#include <QDebug>
+
+#ifdef WITH_GST_APP
+#include <gst/app/gstappsrc.h>
+#endif
+
+#include "gstrecorder.h"
+#include "coredefs.h"
+
+ZGSTRecorder::ZGSTRecorder(QObject *parent)
+    : QObject(parent)
+{
+#ifdef WITH_GST_APP
+    gst_init(nullptr,nullptr);
+#endif
+}
+
+ZGSTRecorder::~ZGSTRecorder()
+{
+    stop();
+}
+
+bool ZGSTRecorder::isGSTSupported() const
+{
+#ifdef WITH_GST_APP
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool ZGSTRecorder::isRecording() const
+{
+#ifdef WITH_GST_APP
+    return (m_data.pipeline != nullptr);
+#else
+    return false;
+#endif
+}
+
+QString ZGSTRecorder::fileExtension(ZRecordFormat format)
+{
+    switch (format) {
+        case WebM: return QSL("webm");
+        case MP4: break;
+    }
+    return QSL("mp4");
+}
+
+bool ZGSTRecorder::start(const QString &fileName, ZRecordFormat format, int frameRate)
+{
+    if (isRecording())
+        stop();
+
+#ifdef WITH_GST_APP
+    m_fileName = fileName;
+    m_frameRate = qMax(1, frameRate);
+    m_frameSize = QSize();
+    m_frameFormat = QImage::Format_Invalid;
+    m_framesCount = 0;
+    m_droppedCount = 0;
+
+    QString description;
+    switch (format) {
+        case WebM:
+            description = QSL("appsrc name=source is-live=true format=time ! videoconvert ! "
+                              "vp8enc deadline=1 cpu-used=4 ! webmmux ! filesink name=sink");
+            break;
+        case MP4:
+            description = QSL("appsrc name=source is-live=true format=time ! videoconvert ! "
+                              "x264enc tune=zerolatency speed-preset=veryfast ! h264parse ! mp4mux ! "
+                              "filesink name=sink");
+            break;
+    }
+
+    GError *err = nullptr;
+    m_data.pipeline = gst_parse_launch(description.toUtf8().constData(), &err);
+    if (err) {
+        const QString message = QSL("GStreamer: Unable to create recording pipeline: %1")
+                                .arg(QString::fromUtf8(err->message));
+        g_error_free(err);
+        if (m_data.pipeline)
+            gst_object_unref(GST_OBJECT(m_data.pipeline)); // NOLINT
+        m_data.clear();
+        Q_EMIT error(message);
+        return false;
+    }
+
+    m_data.appsrc = gst_bin_get_by_name(GST_BIN(m_data.pipeline), "source"); // NOLINT
+    GstElement *sink = gst_bin_get_by_name(GST_BIN(m_data.pipeline), "sink"); // NOLINT
+    if (!m_data.appsrc || !sink) {
+        if (sink)
+            gst_object_unref(sink);
+        releasePipeline();
+        Q_EMIT error(QSL("GStreamer: Not all elements could be created."));
+        return false;
+    }
+
+    const QByteArray location = QFile::encodeName(fileName);
+    g_object_set(sink, "location", location.constData(), nullptr); // NOLINT
+    gst_object_unref(sink);
+
+    GstStateChangeReturn ret = gst_element_set_state(m_data.pipeline, GST_STATE_PLAYING);
+    if (ret == GST_STATE_CHANGE_FAILURE) {
+        releasePipeline();
+        Q_EMIT error(QSL("Unable to set the recording pipeline to the playing state."));
+        return false;
+    }
+
+    m_clock.start();
+
+    Q_EMIT started(m_fileName);
+    return true;
+#else
+    Q_UNUSED(fileName)
+    Q_UNUSED(format)
+    Q_UNUSED(frameRate)
+    return false;
+#endif
+}
+
+// Caps are taken from the first frame, all other frames must match it
+bool ZGSTRecorder::setFrameCaps(const QImage &frame)
+{
+#ifdef WITH_GST_APP
+    const char* format = nullptr;
+    switch (frame.format()) {
+        case QImage::Format_RGB32:
+        case QImage::Format_ARGB32:
+        case QImage::Format_ARGB32_Premultiplied:
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+            format = "BGRx";
+#else
+            format = "xRGB";
+#endif
+            break;
+        case QImage::Format_RGB16:
+            format = "RGB16";
+            break;
+        default:
+            return false;
+    }
+
+    GstCaps *caps = gst_caps_new_simple("video/x-raw",
+                                        "format", G_TYPE_STRING, format,
+                                        "width", G_TYPE_INT, frame.width(),
+                                        "height", G_TYPE_INT, frame.height(),
+                                        "framerate", GST_TYPE_FRACTION, m_frameRate, 1,
+                                        nullptr); // NOLINT
+    gst_app_src_set_caps(GST_APP_SRC(m_data.appsrc), caps); // NOLINT
+    gst_caps_unref(caps);
+
+    // keep about one second of video in the appsrc queue, drop frames above that
+    g_object_set(m_data.appsrc, "max-bytes", // NOLINT
+                 static_cast<guint64>(frame.sizeInBytes()) * static_cast<guint64>(m_frameRate), nullptr);
+
+    m_frameSize = frame.size();
+    m_frameFormat = frame.format();
+    return true;
+#else
+    Q_UNUSED(frame)
+    return false;
+#endif
+}
+
+bool ZGSTRecorder::checkBus()
+{
+#ifdef WITH_GST_APP
+    GstBus *bus = gst_element_get_bus(m_data.pipeline);
+    GstMessage *msg = gst_bus_pop_filtered(bus, GST_MESSAGE_ERROR);
+    gst_object_unref(bus);
+
+    if (msg == nullptr) return true;
+
+    gchar  *debug = nullptr;
+    GError *err = nullptr;
+    gst_message_parse_error(msg, &err, &debug);
+    const QString message = QSL("GStreamer Bus ERROR: %1").arg(QString::fromUtf8(err->message));
+    g_free(debug);
+    g_error_free(err);
+    gst_message_unref(msg);
+
+    // the failed pipeline would never deliver EOS, don't wait for it
+    releasePipeline();
+    Q_EMIT error(message);
+#endif
+    return false;
+}
+
+bool ZGSTRecorder::pushFrame(const QImage &frame)
+{
+    if (!isRecording() || frame.isNull()) return false;
+    if (!checkBus()) return false;
+
+#ifdef WITH_GST_APP
+    QImage image = frame;
+    if (m_frameSize.isEmpty()) {
+        if (!setFrameCaps(image)) {
+            image = image.convertToFormat(QImage::Format_RGB32);
+            setFrameCaps(image);
+        }
+    } else if (image.format() != m_frameFormat) {
+        image = image.convertToFormat(m_frameFormat);
+    }
+
+    if (image.size() != m_frameSize) {
+        qWarning() << "Recorder: frame size changed, frame dropped";
+        m_droppedCount++;
+        return false;
+    }
+
+    // the encoder is late, don't grow the queue
+    auto *appsrc = GST_APP_SRC(m_data.appsrc); // NOLINT
+    if (gst_app_src_get_current_level_bytes(appsrc) >= gst_app_src_get_max_bytes(appsrc)) {
+        m_droppedCount++;
+        return false;
+    }
+
+    // the buffer references image data, the image is released together with the buffer
+    auto *holder = new QImage(image);
+    const auto size = static_cast<gsize>(holder->sizeInBytes());
+    GstBuffer *buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY,
+                                                    const_cast<uchar *>(holder->constBits()),
+                                                    size, 0, size, holder,
+                                                    [](gpointer data){
+        delete static_cast<QImage *>(data);
+    });
+
+    GST_BUFFER_PTS(buffer) = static_cast<GstClockTime>(m_clock.nsecsElapsed()); // NOLINT
+    GST_BUFFER_DURATION(buffer) = gst_util_uint64_scale_int(1, GST_SECOND, m_frameRate); // NOLINT
+
+    if (gst_app_src_push_buffer(appsrc, buffer) != GST_FLOW_OK) {
+        checkBus();
+        return false;
+    }
+
+    m_framesCount++;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ZGSTRecorder::stop()
+{
+#ifdef WITH_GST_APP
+    const GstClockTime eosTimeout = 5 * GST_SECOND;
+
+    if (isRecording()) {
+        // wait for muxer to finalize the file
+        if (m_data.appsrc && (m_framesCount > 0)) {
+            gst_app_src_end_of_stream(GST_APP_SRC(m_data.appsrc)); // NOLINT
+            GstBus *bus = gst_element_get_bus(m_data.pipeline);
+            GstMessage *msg = gst_bus_timed_pop_filtered(bus, eosTimeout,
+                                                         static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+            if (msg == nullptr)
+                qWarning() << "GStreamer: recording pipeline was not finished in time";
+            if (msg)
+                gst_message_unref(msg);
+            gst_object_unref(bus);
+        }
+
+        releasePipeline();
+
+        // the muxer leaves an empty or truncated file without any frames
+        if (m_framesCount == 0) {
+            QFile::remove(m_fileName);
+            Q_EMIT error(QSL("No frames were recorded, %1 was removed.").arg(m_fileName));
+            return;
+        }
+
+        Q_EMIT stopped(m_fileName, m_framesCount, m_droppedCount);
+    }
+#endif
+}
+
+// Drops the pipeline without finalizing the file, for the error paths
+// and after the EOS in stop()
+void ZGSTRecorder::releasePipeline()
+{
+#ifdef WITH_GST_APP
+    if (m_data.pipeline == nullptr) return;
+
+    gst_element_set_state(m_data.pipeline, GST_STATE_NULL);
+
+    if (m_data.appsrc)
+        gst_object_unref(m_data.appsrc);
+    gst_object_unref(GST_OBJECT(m_data.pipeline)); // NOLINT
+
+    m_data.clear();
+#endif
+}
+
+#ifdef WITH_GST_APP
+void CRecorderData::clear()
+{
+    pipeline = nullptr;
+    appsrc = nullptr;
+}
+#endif
@@ -0,0 +1,68 @@
+#ifndef GSTRECORDER_H
+#define GSTRECORDER_H
+
+#include <QObject>
+#include <QImage>
+#include <QElapsedTimer>
+
+#ifdef WITH_GST_APP
+#include <gst/gst.h>
+#endif
+
+struct CRecorderData {
+#ifdef WITH_GST_APP
+    GstElement *pipeline { nullptr };
+    GstElement *appsrc { nullptr };
+    void clear();
+#else
+    int dummy { 0 };
+#endif
+};
+
+// Streams captured frames into GStreamer encoding pipeline through appsrc.
+// Frames are passed to the pipeline without copying, each buffer keeps
+// a shallow copy of its image until GStreamer releases it.
+class ZGSTRecorder : public QObject
+{
+    Q_OBJECT
+public:
+    enum ZRecordFormat {
+        MP4=0,
+        WebM=1
+    };
+    Q_ENUM(ZRecordFormat)
+
+private:
+    CRecorderData m_data;
+    QString m_fileName;
+    QSize m_frameSize;
+    QImage::Format m_frameFormat { QImage::Format_Invalid };
+    QElapsedTimer m_clock;
+    int m_frameRate { 0 };
+    quint64 m_framesCount { 0 };
+    quint64 m_droppedCount { 0 };
+
+    bool setFrameCaps(const QImage &frame);
+    bool checkBus();
+    void releasePipeline();
+
+public:
+    explicit ZGSTRecorder(QObject *parent = nullptr);
+    ~ZGSTRecorder() override;
+    bool isGSTSupported() const;
+    bool isRecording() const;
+
+    static QString fileExtension(ZRecordFormat format);
+
+public Q_SLOTS:
+    bool start(const QString& fileName, ZRecordFormat format, int frameRate);
+    bool pushFrame(const QImage& frame);
+    void stop();
+
+Q_SIGNALS:
+    void started(const QString& fileName);
+    void stopped(const QString& fileName, quint64 frames, quint64 dropped);
+    void error(const QString& message);
+};
+
+#endif // GSTRECORDER_H
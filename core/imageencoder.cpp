@@ -0,0 +1,298 @@
+#include <QFile>
+#include <QFileInfo>
+#include <QImageWriter>
+#include <QElapsedTimer>
+#include <QtEndian>
+#include <QDebug>
+
+#include <cstring>
+
+#ifdef WITH_WEBP
+#include <webp/encode.h>
+#endif
+
+#include "imageencoder.h"
+#include "pngwriter.h"
+#include "coredefs.h"
+
+namespace {
+const int qoiHeaderSize = 14;
+const int qoiIndexSize = 64;
+const int qoiMaxRun = 62;
+const quint8 qoiOpIndex = 0x00;
+const quint8 qoiOpDiff = 0x40;
+const quint8 qoiOpLuma = 0x80;
+const quint8 qoiOpRun = 0xc0;
+const quint8 qoiOpRGB = 0xfe;
+const quint8 qoiOpRGBA = 0xff;
+const quint8 qoiEndMarker[] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+void appendUInt32(QByteArray &data, quint32 value)
+{
+    const quint32 be = qToBigEndian(value);
+    data.append(reinterpret_cast<const char *>(&be), sizeof(be));
+}
+
+int qoiHash(const quint8 *px)
+{
+    return (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % qoiIndexSize; // NOLINT
+}
+}
+
+const QVector<ZImageEncoder::ZEncoderInfo> &ZImageEncoder::encoders()
+{
+    // in ZImageCodec order, matches ZGenericFuncs::zImageFormats
+    static const QVector<ZEncoderInfo> res = {
+        { PNG, "png", &ZImageEncoder::encodePng },
+        { JPG, "jpg", &ZImageEncoder::encodeJpg },
+        { QOI, "qoi", &ZImageEncoder::encodeQoi },
+        { WebP, "webp", &ZImageEncoder::encodeWebP }
+    };
+    return res;
+}
+
+const ZImageEncoder::ZEncoderInfo *ZImageEncoder::encoderInfo(ZImageEncoder::ZImageCodec codec)
+{
+    for (const auto &info : encoders()) {
+        if (info.codec == codec)
+            return &info;
+    }
+    return nullptr;
+}
+
+bool ZImageEncoder::isSupported(ZImageEncoder::ZImageCodec codec)
+{
+    if (codec == WebP) {
+#ifdef WITH_WEBP
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    return (encoderInfo(codec) != nullptr);
+}
+
+QString ZImageEncoder::fileExtension(ZImageEncoder::ZImageCodec codec)
+{
+    const ZEncoderInfo *info = encoderInfo(codec);
+    if (info == nullptr) return QString();
+
+    return QString::fromLatin1(info->extension);
+}
+
+bool ZImageEncoder::codecForFileName(const QString &fileName, ZImageEncoder::ZImageCodec *codec)
+{
+    QString suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix == QSL("jpeg"))
+        suffix = QSL("jpg");
+
+    for (const auto &info : encoders()) {
+        if (suffix == QLatin1String(info.extension) && isSupported(info.codec)) {
+            *codec = info.codec;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ZImageEncoder::encode(const QImage &image, const QString &fileName,
+                           const ZImageEncoder::ZEncoderOptions &options, QString *error)
+{
+    const ZEncoderInfo *info = encoderInfo(options.codec);
+    if (image.isNull() || info == nullptr || !isSupported(options.codec)) {
+        if (error)
+            *error = QSL("Unsupported image codec");
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!info->encode(image, fileName, options, error))
+        return false;
+
+    qInfo() << "Encoded" << info->extension << image.size() << "in" << timer.elapsed() << "ms,"
+            << QFileInfo(fileName).size() << "bytes:" << fileName;
+
+    return true;
+}
+
+bool ZImageEncoder::writeFile(const QString &fileName, const QByteArray &data, QString *error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(data) != data.size()) {
+        if (error)
+            *error = file.errorString();
+        file.remove();
+        return false;
+    }
+
+    file.close();
+    return true;
+}
+
+bool ZImageEncoder::encodePng(const QImage &image, const QString &fileName,
+                              const ZImageEncoder::ZEncoderOptions &options, QString *error)
+{
+    const int compression = (options.compression >= 0) ? options.compression
+                                                        : ZPngWriter::compressionFromQuality(options.quality);
+    return ZPngWriter::write(image, fileName, compression, error);
+}
+
+bool ZImageEncoder::encodeJpg(const QImage &image, const QString &fileName,
+                              const ZImageEncoder::ZEncoderOptions &options, QString *error)
+{
+    QImageWriter writer(fileName, QByteArrayLiteral("jpg"));
+    writer.setQuality(options.quality);
+    if (!writer.write(image)) {
+        if (error)
+            *error = writer.errorString();
+        return false;
+    }
+    return true;
+}
+
+// The Quite OK Image format, see https://qoiformat.org/qoi-specification.pdf
+QByteArray ZImageEncoder::qoiData(const QImage &image)
+{
+    const bool alpha = image.hasAlphaChannel();
+    const QImage img = image.convertToFormat(QImage::Format_RGBA8888);
+    const int channels = alpha ? 4 : 3;
+
+    QByteArray res;
+    res.reserve(qoiHeaderSize + img.width() * img.height() * (channels + 1) + static_cast<int>(sizeof(qoiEndMarker)));
+    res.append("qoif");
+    appendUInt32(res, static_cast<quint32>(img.width()));
+    appendUInt32(res, static_cast<quint32>(img.height()));
+    res.append(static_cast<char>(channels));
+    res.append(static_cast<char>(0)); // sRGB with linear alpha
+
+    quint8 index[qoiIndexSize * 4] = { 0 };
+    quint8 prev[4] = { 0, 0, 0, 255 }; // NOLINT
+    int run = 0;
+
+    for (int y = 0; y < img.height(); y++) {
+        const quint8 *line = img.constScanLine(y);
+        for (int x = 0; x < img.width(); x++) {
+            quint8 px[4];
+            memcpy(px, line + x * 4, sizeof(px)); // NOLINT
+            if (!alpha)
+                px[3] = 255; // NOLINT
+
+            if (memcmp(px, prev, sizeof(px)) == 0) {
+                run++;
+                if (run == qoiMaxRun) {
+                    res.append(static_cast<char>(qoiOpRun | (run - 1)));
+                    run = 0;
+                }
+                continue;
+            }
+
+            if (run > 0) {
+                res.append(static_cast<char>(qoiOpRun | (run - 1)));
+                run = 0;
+            }
+
+            const int hash = qoiHash(px);
+            quint8 *slot = index + hash * 4; // NOLINT
+            if (memcmp(slot, px, sizeof(px)) == 0) {
+                res.append(static_cast<char>(qoiOpIndex | hash));
+            } else {
+                memcpy(slot, px, sizeof(px));
+
+                if (px[3] == prev[3]) {
+                    const auto dr = static_cast<signed char>(px[0] - prev[0]);
+                    const auto dg = static_cast<signed char>(px[1] - prev[1]);
+                    const auto db = static_cast<signed char>(px[2] - prev[2]);
+                    const auto drdg = static_cast<signed char>(dr - dg);
+                    const auto dbdg = static_cast<signed char>(db - dg);
+
+                    if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                        res.append(static_cast<char>(qoiOpDiff | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2))); // NOLINT
+                    } else if (dg >= -32 && dg <= 31 && drdg >= -8 && drdg <= 7 && dbdg >= -8 && dbdg <= 7) { // NOLINT
+                        res.append(static_cast<char>(qoiOpLuma | (dg + 32))); // NOLINT
+                        res.append(static_cast<char>(((drdg + 8) << 4) | (dbdg + 8))); // NOLINT
+                    } else {
+                        res.append(static_cast<char>(qoiOpRGB));
+                        res.append(reinterpret_cast<const char *>(px), 3); // NOLINT
+                    }
+                } else {
+                    res.append(static_cast<char>(qoiOpRGBA));
+                    res.append(reinterpret_cast<const char *>(px), 4); // NOLINT
+                }
+            }
+
+            memcpy(prev, px, sizeof(px));
+        }
+    }
+
+    if (run > 0)
+        res.append(static_cast<char>(qoiOpRun | (run - 1)));
+
+    res.append(reinterpret_cast<const char *>(qoiEndMarker), sizeof(qoiEndMarker));
+    return res;
+}
+
+bool ZImageEncoder::encodeQoi(const QImage &image, const QString &fileName,
+                              const ZImageEncoder::ZEncoderOptions &options, QString *error)
+{
+    Q_UNUSED(options)
+
+    return writeFile(fileName, qoiData(image), error);
+}
+
+// Lossless WebP, the quality option selects the compression effort
+bool ZImageEncoder::encodeWebP(const QImage &image, const QString &fileName,
+                               const ZImageEncoder::ZEncoderOptions &options, QString *error)
+{
+#ifdef WITH_WEBP
+    const QImage img = image.convertToFormat(QImage::Format_RGBA8888);
+
+    WebPConfig config;
+    WebPPicture picture;
+    if (!WebPConfigInit(&config) || !WebPPictureInit(&picture)) {
+        if (error)
+            *error = QSL("libwebp version mismatch");
+        return false;
+    }
+
+    config.lossless = 1;
+    if (options.quality >= 0)
+        config.quality = static_cast<float>(qBound(0, options.quality, 100)); // NOLINT
+
+    picture.use_argb = 1;
+    picture.width = img.width();
+    picture.height = img.height();
+    if (!WebPPictureImportRGBA(&picture, img.constBits(), img.bytesPerLine())) {
+        if (error)
+            *error = QSL("WebP: out of memory");
+        return false;
+    }
+
+    WebPMemoryWriter writer;
+    WebPMemoryWriterInit(&writer);
+    picture.writer = WebPMemoryWrite;
+    picture.custom_ptr = &writer;
+
+    const bool res = (WebPEncode(&config, &picture) != 0);
+    WebPPictureFree(&picture);
+    if (!res) {
+        WebPMemoryWriterClear(&writer);
+        if (error)
+            *error = QSL("WebP encoding failed");
+        return false;
+    }
+
+    const QByteArray data(reinterpret_cast<const char *>(writer.mem), static_cast<int>(writer.size));
+    WebPMemoryWriterClear(&writer);
+
+    return writeFile(fileName, data, error);
+#else
+    Q_UNUSED(image)
+    Q_UNUSED(fileName)
+    Q_UNUSED(options)
+    Q_UNUSED(error)
+    return false;
+#endif
+}
@@ -0,0 +1,57 @@
+#ifndef IMAGEENCODER_H
+#define IMAGEENCODER_H
+
+#include <QImage>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+
+// Still image encoders, selected by codec. Each codec is one entry in the
+// encoders table, every save logs the encode time and the output size.
+class ZImageEncoder
+{
+public:
+    enum ZImageCodec {
+        PNG=0,
+        JPG=1,
+        QOI=2,
+        WebP=3
+    };
+
+    struct ZEncoderOptions {
+        ZImageCodec codec { PNG };
+        int quality { -1 };
+        int compression { -1 };
+    };
+
+private:
+    using ZEncodeFunc = bool (*)(const QImage &image, const QString &fileName,
+                                 const ZEncoderOptions &options, QString *error);
+
+    struct ZEncoderInfo {
+        ZImageCodec codec;
+        const char *extension;
+        ZEncodeFunc encode;
+    };
+
+    static const QVector<ZEncoderInfo> &encoders();
+    static const ZEncoderInfo *encoderInfo(ZImageCodec codec);
+
+    static bool encodePng(const QImage &image, const QString &fileName, const ZEncoderOptions &options, QString *error);
+    static bool encodeJpg(const QImage &image, const QString &fileName, const ZEncoderOptions &options, QString *error);
+    static bool encodeQoi(const QImage &image, const QString &fileName, const ZEncoderOptions &options, QString *error);
+    static bool encodeWebP(const QImage &image, const QString &fileName, const ZEncoderOptions &options, QString *error);
+    static bool writeFile(const QString &fileName, const QByteArray &data, QString *error);
+    static QByteArray qoiData(const QImage &image);
+
+public:
+    ZImageEncoder() = delete;
+
+    static bool isSupported(ZImageCodec codec);
+    static QString fileExtension(ZImageCodec codec);
+    static bool codecForFileName(const QString &fileName, ZImageCodec *codec);
+    static bool encode(const QImage &image, const QString &fileName, const ZEncoderOptions &options,
+                       QString *error = nullptr);
+};
+
+#endif // IMAGEENCODER_H
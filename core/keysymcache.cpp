@@ -0,0 +1,53 @@
+#include <QMutexLocker>
+#include <QDebug>
+
+#include "keysymcache.h"
+
+ZKeySymbolsCache::ZKeySymbolsCache(QObject *parent)
+    : ZAbstractXCBEventListener(parent)
+{
+    ZXCBTools::addEventListener(this, XCB_MAPPING_NOTIFY);
+
+    m_symbols = xcb_key_symbols_alloc(ZXCBTools::connection(ZXCBTools::instance()));
+    if (m_symbols == nullptr)
+        qWarning() << "Unable to allocate XCB key symbols table";
+}
+
+ZKeySymbolsCache::~ZKeySymbolsCache()
+{
+    ZXCBTools::removeEventListener(this);
+
+    QMutexLocker locker(&m_symbolsMutex);
+    if (m_symbols)
+        xcb_key_symbols_free(m_symbols);
+    m_symbols = nullptr;
+}
+
+// Returns the first keycode for the keysym, 0 if none
+xcb_keycode_t ZKeySymbolsCache::keycode(xcb_keysym_t keysym)
+{
+    QMutexLocker locker(&m_symbolsMutex);
+
+    if (m_symbols == nullptr) return 0;
+
+    QScopedPointer<xcb_keycode_t,QScopedPointerPodDeleter> keyCodes(xcb_key_symbols_get_keycode(m_symbols, keysym));
+    if (keyCodes.isNull()) return 0;
+
+    return *(keyCodes.data());
+}
+
+void ZKeySymbolsCache::nativeEventHandler(const xcb_generic_event_t *event)
+{
+    auto *mev = const_cast<xcb_mapping_notify_event_t *>(reinterpret_cast<const xcb_mapping_notify_event_t *>(event));
+
+    // modifier and pointer mapping changes do not affect keycodes
+    if (mev->request != XCB_MAPPING_KEYBOARD) return;
+
+    {
+        QMutexLocker locker(&m_symbolsMutex);
+        if (m_symbols)
+            xcb_refresh_keyboard_mapping(m_symbols, mev);
+    }
+
+    Q_EMIT mappingChanged();
+}
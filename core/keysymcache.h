@@ -0,0 +1,34 @@
+#ifndef KEYSYMCACHE_H
+#define KEYSYMCACHE_H
+
+#include <QObject>
+#include <QMutex>
+
+#include "xcbtools.h"
+
+// Process-wide copy of the keyboard mapping. The mapping is downloaded once
+// and refreshed only when the X server reports a change with MappingNotify.
+class ZKeySymbolsCache : public ZAbstractXCBEventListener
+{
+    Q_OBJECT
+private:
+    Q_DISABLE_COPY(ZKeySymbolsCache)
+
+    QMutex m_symbolsMutex;
+    xcb_key_symbols_t* m_symbols { nullptr };
+
+public:
+    explicit ZKeySymbolsCache(QObject* parent = nullptr);
+    ~ZKeySymbolsCache() override;
+
+    xcb_keycode_t keycode(xcb_keysym_t keysym);
+
+Q_SIGNALS:
+    void mappingChanged();
+
+protected:
+    void nativeEventHandler(const xcb_generic_event_t* event) override;
+
+};
+
+#endif // KEYSYMCACHE_H
@@ -0,0 +1,200 @@
+#include <QRgb>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ZPIXELOPS_X86 1
+#endif
+
+#include "pixelops.h"
+
+namespace {
+
+// 2:10:10:10 packed pixels, the top 8 bits of each channel are moved
+// to the ARGB32 positions and alpha is set to opaque
+const quint32 depth30Alpha = 0xff000000U;
+const quint32 depth30Red = 0x00ff0000U;
+const quint32 depth30Green = 0x0000ff00U;
+const quint32 depth30Blue = 0x000000ffU;
+
+#ifdef ZPIXELOPS_X86
+
+__attribute__((target("sse2")))
+quint32 convertDepth30SSE2(quint32 *pixels, quint32 count)
+{
+    const quint32 step = 4;
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(depth30Alpha));
+    const __m128i red = _mm_set1_epi32(static_cast<int>(depth30Red));
+    const __m128i green = _mm_set1_epi32(static_cast<int>(depth30Green));
+    const __m128i blue = _mm_set1_epi32(static_cast<int>(depth30Blue));
+
+    quint32 i = 0;
+    for (; i + step <= count; i += step) {
+        auto *p = reinterpret_cast<__m128i *>(pixels + i);
+        const __m128i v = _mm_loadu_si128(p);
+        __m128i res = _mm_and_si128(_mm_srli_epi32(v, 6), red); // NOLINT
+        res = _mm_or_si128(res, _mm_and_si128(_mm_srli_epi32(v, 4), green));
+        res = _mm_or_si128(res, _mm_and_si128(_mm_srli_epi32(v, 2), blue));
+        _mm_storeu_si128(p, _mm_or_si128(res, alpha));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+quint32 convertDepth30AVX2(quint32 *pixels, quint32 count)
+{
+    const quint32 step = 8;
+    const __m256i alpha = _mm256_set1_epi32(static_cast<int>(depth30Alpha));
+    const __m256i red = _mm256_set1_epi32(static_cast<int>(depth30Red));
+    const __m256i green = _mm256_set1_epi32(static_cast<int>(depth30Green));
+    const __m256i blue = _mm256_set1_epi32(static_cast<int>(depth30Blue));
+
+    quint32 i = 0;
+    for (; i + step <= count; i += step) {
+        auto *p = reinterpret_cast<__m256i *>(pixels + i);
+        const __m256i v = _mm256_loadu_si256(p);
+        __m256i res = _mm256_and_si256(_mm256_srli_epi32(v, 6), red); // NOLINT
+        res = _mm256_or_si256(res, _mm256_and_si256(_mm256_srli_epi32(v, 4), green));
+        res = _mm256_or_si256(res, _mm256_and_si256(_mm256_srli_epi32(v, 2), blue));
+        _mm256_storeu_si256(p, _mm256_or_si256(res, alpha));
+    }
+    return i;
+}
+
+__attribute__((target("sse2")))
+quint32 countChangedPixelsSSE2(const quint32 *a, const quint32 *b, quint32 count, quint32 *changed)
+{
+    const quint32 step = 4;
+    const int allEqual = 0xf;
+
+    quint32 res = 0;
+    quint32 i = 0;
+    for (; i + step <= count; i += step) {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        const int equal = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(va, vb)));
+        res += static_cast<quint32>(__builtin_popcount(static_cast<unsigned int>(equal ^ allEqual)));
+    }
+    *changed = res;
+    return i;
+}
+
+__attribute__((target("avx2")))
+quint32 countChangedPixelsAVX2(const quint32 *a, const quint32 *b, quint32 count, quint32 *changed)
+{
+    const quint32 step = 8;
+    const int allEqual = 0xff;
+
+    quint32 res = 0;
+    quint32 i = 0;
+    for (; i + step <= count; i += step) {
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        const int equal = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(va, vb)));
+        res += static_cast<quint32>(__builtin_popcount(static_cast<unsigned int>(equal ^ allEqual)));
+    }
+    *changed = res;
+    return i;
+}
+
+#endif
+
+ZPixelOps::ZInstructionSet detectInstructionSet()
+{
+#ifdef ZPIXELOPS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return ZPixelOps::AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return ZPixelOps::SSE2;
+#endif
+    return ZPixelOps::Scalar;
+}
+
+}
+
+ZPixelOps::ZInstructionSet ZPixelOps::bestInstructionSet()
+{
+    static const ZInstructionSet res = detectInstructionSet();
+    return res;
+}
+
+void ZPixelOps::convertDepth30(quint32 *pixels, quint32 count)
+{
+    convertDepth30(pixels, count, bestInstructionSet());
+}
+
+void ZPixelOps::convertDepth30(quint32 *pixels, quint32 count, ZInstructionSet isa)
+{
+    quint32 done = 0;
+
+#ifdef ZPIXELOPS_X86
+    switch (qMin(isa, bestInstructionSet())) {
+        case AVX2:
+            done = convertDepth30AVX2(pixels, count);
+            break;
+        case SSE2:
+            done = convertDepth30SSE2(pixels, count);
+            break;
+        case Scalar:
+            break;
+    }
+#else
+    Q_UNUSED(isa)
+#endif
+
+    // the tail is converted by the reference loop
+    if (done < count)
+        convertDepth30Scalar(pixels + done, count - done);
+}
+
+void ZPixelOps::convertDepth30Scalar(quint32 *pixels, quint32 count)
+{
+    for (quint32 i = 0; i < count; i++) {
+        int r = (pixels[i] >> 22) & 0xff; // NOLINT
+        int g = (pixels[i] >> 12) & 0xff; // NOLINT
+        int b = (pixels[i] >>  2) & 0xff; // NOLINT
+
+        pixels[i] = qRgba(r, g, b, 0xff); // NOLINT
+    }
+}
+
+quint32 ZPixelOps::countChangedPixels(const quint32 *a, const quint32 *b, quint32 count)
+{
+    return countChangedPixels(a, b, count, bestInstructionSet());
+}
+
+quint32 ZPixelOps::countChangedPixels(const quint32 *a, const quint32 *b, quint32 count, ZInstructionSet isa)
+{
+    quint32 done = 0;
+    quint32 res = 0;
+
+#ifdef ZPIXELOPS_X86
+    switch (qMin(isa, bestInstructionSet())) {
+        case AVX2:
+            done = countChangedPixelsAVX2(a, b, count, &res);
+            break;
+        case SSE2:
+            done = countChangedPixelsSSE2(a, b, count, &res);
+            break;
+        case Scalar:
+            break;
+    }
+#else
+    Q_UNUSED(isa)
+#endif
+
+    if (done < count)
+        res += countChangedPixelsScalar(a + done, b + done, count - done);
+
+    return res;
+}
+
+quint32 ZPixelOps::countChangedPixelsScalar(const quint32 *a, const quint32 *b, quint32 count)
+{
+    quint32 res = 0;
+    for (quint32 i = 0; i < count; i++) {
+        if (a[i] != b[i])
+            res++;
+    }
+    return res;
+}
@@ -0,0 +1,31 @@
+#ifndef PIXELOPS_H
+#define PIXELOPS_H
+
+#include <QtGlobal>
+
+// Pixel kernels for the capture path. Vectorized versions are selected at
+// runtime by CPU features, the scalar versions are the reference.
+// The overloads taking an instruction set are meant for tests and benchmarks,
+// sets not supported by the CPU fall back to the best supported one.
+class ZPixelOps
+{
+public:
+    enum ZInstructionSet {
+        Scalar=0,
+        SSE2=1,
+        AVX2=2
+    };
+
+    ZPixelOps() = delete;
+
+    static ZInstructionSet bestInstructionSet();
+
+    static void convertDepth30(quint32 *pixels, quint32 count);
+    static void convertDepth30(quint32 *pixels, quint32 count, ZInstructionSet isa);
+    static void convertDepth30Scalar(quint32 *pixels, quint32 count);
+    static quint32 countChangedPixels(const quint32 *a, const quint32 *b, quint32 count);
+    static quint32 countChangedPixels(const quint32 *a, const quint32 *b, quint32 count, ZInstructionSet isa);
+    static quint32 countChangedPixelsScalar(const quint32 *a, const quint32 *b, quint32 count);
+};
+
+#endif // PIXELOPS_H
@@ -0,0 +1,352 @@
+#include <QFile>
+#include <QThread>
+#include <QSemaphore>
+#include <QtEndian>
+
+#include <cstdlib>
+#include <cstring>
+#include <zlib.h>
+
+#include "pngwriter.h"
+#include "coredefs.h"
+
+namespace {
+const int maxCompression = 9;
+const int maxQuality = 100;
+const int dictionarySize = 32768;
+const int minStripeBytes = 256 * 1024;
+const int deflateWindowBits = -15; // raw deflate, zlib header is written by us
+const int deflateMemLevel = 8;
+
+enum ZPngFilter {
+    FilterNone = 0,
+    FilterSub = 1,
+    FilterUp = 2,
+    FilterPaeth = 4
+};
+
+void appendUInt32(QByteArray &data, quint32 value)
+{
+    const quint32 be = qToBigEndian(value);
+    data.append(reinterpret_cast<const char *>(&be), sizeof(be));
+}
+
+bool writeChunk(QFile &file, const char *type, const QByteArray &data)
+{
+    QByteArray chunk;
+    appendUInt32(chunk, static_cast<quint32>(data.size()));
+    chunk.append(type, 4); // NOLINT
+    chunk.append(data);
+
+    const uLong crc = crc32(crc32(0L, Z_NULL, 0),
+                            reinterpret_cast<const Bytef *>(chunk.constData() + 4), // NOLINT
+                            static_cast<uInt>(chunk.size() - 4)); // NOLINT
+    appendUInt32(chunk, static_cast<quint32>(crc));
+
+    return (file.write(chunk) == chunk.size());
+}
+
+// Unpacks one image row into PNG byte order: RGB or RGBA
+void unpackRow(const QRgb *line, int width, bool alpha, quint8 *dst)
+{
+    for (int x = 0; x < width; x++) {
+        const QRgb px = line[x]; // NOLINT
+        *(dst++) = static_cast<quint8>(qRed(px)); // NOLINT
+        *(dst++) = static_cast<quint8>(qGreen(px)); // NOLINT
+        *(dst++) = static_cast<quint8>(qBlue(px)); // NOLINT
+        if (alpha)
+            *(dst++) = static_cast<quint8>(qAlpha(px)); // NOLINT
+    }
+}
+
+int paethPredictor(int a, int b, int c)
+{
+    const int p = a + b - c;
+    const int pa = std::abs(p - a);
+    const int pb = std::abs(p - b);
+    const int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    if (pb <= pc) return b;
+    return c;
+}
+
+// Appends the filtered row, the filter is chosen with the minimum sum of
+// absolute differences heuristic
+void filterRow(const quint8 *cur, const quint8 *prev, int size, int bpp,
+               QByteArray &candidates, QByteArray &out)
+{
+    static const ZPngFilter filters[] = { FilterNone, FilterSub, FilterUp, FilterPaeth };
+    const int filtersCount = sizeof(filters) / sizeof(filters[0]);
+
+    candidates.resize(size * filtersCount);
+    auto *none = reinterpret_cast<quint8 *>(candidates.data());
+    quint8 *sub = none + size; // NOLINT
+    quint8 *up = sub + size; // NOLINT
+    quint8 *paeth = up + size; // NOLINT
+
+    int costs[filtersCount] = { 0, 0, 0, 0 };
+    for (int i = 0; i < size; i++) {
+        const int a = (i >= bpp) ? cur[i - bpp] : 0; // NOLINT
+        const int b = prev[i]; // NOLINT
+        const int c = (i >= bpp) ? prev[i - bpp] : 0; // NOLINT
+        const int x = cur[i]; // NOLINT
+
+        none[i] = static_cast<quint8>(x); // NOLINT
+        sub[i] = static_cast<quint8>(x - a); // NOLINT
+        up[i] = static_cast<quint8>(x - b); // NOLINT
+        paeth[i] = static_cast<quint8>(x - paethPredictor(a, b, c)); // NOLINT
+
+        costs[0] += std::abs(static_cast<signed char>(none[i])); // NOLINT
+        costs[1] += std::abs(static_cast<signed char>(sub[i])); // NOLINT
+        costs[2] += std::abs(static_cast<signed char>(up[i])); // NOLINT
+        costs[3] += std::abs(static_cast<signed char>(paeth[i])); // NOLINT
+    }
+
+    int best = 0;
+    for (int i = 1; i < filtersCount; i++) {
+        if (costs[i] < costs[best])
+            best = i;
+    }
+
+    out.append(static_cast<char>(filters[best])); // NOLINT
+    out.append(candidates.constData() + best * size, size); // NOLINT
+}
+
+// Filters rows [top, bottom) of the rect into PNG scanlines
+QByteArray filterRows(const QImage &image, const QRect &rect, int top, int bottom, bool alpha)
+{
+    const int bpp = alpha ? 4 : 3;
+    const int rowSize = rect.width() * bpp;
+
+    QByteArray res;
+    res.reserve((rowSize + 1) * (bottom - top));
+
+    QByteArray prev(rowSize, '\0');
+    QByteArray cur(rowSize, '\0');
+    QByteArray candidates;
+
+    if (top > rect.top()) {
+        unpackRow(reinterpret_cast<const QRgb *>(image.constScanLine(top - 1)) + rect.left(), // NOLINT
+                  rect.width(), alpha, reinterpret_cast<quint8 *>(prev.data()));
+    }
+
+    for (int y = top; y < bottom; y++) {
+        unpackRow(reinterpret_cast<const QRgb *>(image.constScanLine(y)) + rect.left(), // NOLINT
+                  rect.width(), alpha, reinterpret_cast<quint8 *>(cur.data()));
+        filterRow(reinterpret_cast<const quint8 *>(cur.constData()),
+                  reinterpret_cast<const quint8 *>(prev.constData()),
+                  rowSize, bpp, candidates, res);
+        prev.swap(cur);
+    }
+
+    return res;
+}
+
+struct ZStripe {
+    int top { 0 };
+    int bottom { 0 };
+    QByteArray data;
+    uLong adler { 0 };
+    uLong length { 0 };
+    bool ok { false };
+};
+
+void deflateStripe(const QImage &image, const QRect &rect, bool alpha, int compression,
+                   bool last, ZStripe *stripe)
+{
+    const int bpp = alpha ? 4 : 3;
+    const int scanlineSize = rect.width() * bpp + 1;
+
+    // filtering depends on the previous row only, so the tail of the previous
+    // stripe is recomputed here as deflate dictionary
+    const int dictionaryRows = qMin(stripe->top - rect.top(), (dictionarySize + scanlineSize - 1) / scanlineSize);
+    const QByteArray raw = filterRows(image, rect, stripe->top - dictionaryRows, stripe->bottom, alpha);
+    const int dictionaryBytes = dictionaryRows * scanlineSize;
+
+    const auto *input = reinterpret_cast<const Bytef *>(raw.constData()) + dictionaryBytes; // NOLINT
+    const auto inputSize = static_cast<uLong>(raw.size() - dictionaryBytes);
+
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if (deflateInit2(&strm, compression, Z_DEFLATED, deflateWindowBits,
+                     deflateMemLevel, Z_DEFAULT_STRATEGY) != Z_OK)
+        return;
+
+    if (dictionaryBytes > 0) {
+        const int size = qMin(dictionaryBytes, dictionarySize);
+        deflateSetDictionary(&strm, input - size, static_cast<uInt>(size)); // NOLINT
+    }
+
+    // sync flush ends the stripe on a byte boundary with a non-final block
+    const uLong flushReserve = 16;
+    stripe->data.resize(static_cast<int>(deflateBound(&strm, inputSize) + flushReserve));
+    strm.next_in = const_cast<Bytef *>(input);
+    strm.avail_in = static_cast<uInt>(inputSize);
+    strm.next_out = reinterpret_cast<Bytef *>(stripe->data.data());
+    strm.avail_out = static_cast<uInt>(stripe->data.size());
+
+    const int res = deflate(&strm, last ? Z_FINISH : Z_SYNC_FLUSH);
+    stripe->ok = last ? (res == Z_STREAM_END) : (res == Z_OK && strm.avail_in == 0);
+    stripe->data.truncate(static_cast<int>(strm.total_out));
+    deflateEnd(&strm);
+
+    stripe->adler = adler32(adler32(0L, Z_NULL, 0), input, static_cast<uInt>(inputSize));
+    stripe->length = inputSize;
+}
+}
+
+// The same quality to compression mapping as Qt PNG writer does
+int ZPngWriter::compressionFromQuality(int quality)
+{
+    return qBound(0, (maxQuality - qBound(0, quality, maxQuality)) * maxCompression / 91, maxCompression); // NOLINT
+}
+
+// Stripes run on a pool of their own. Stripe tasks never wait for anything, so
+// the caller blocked on them can't starve the pool even when it is itself
+// a pool thread, e.g. of the global pool or of the encoder queue.
+QThreadPool *ZPngWriter::threadPool()
+{
+    static QThreadPool pool;
+    return &pool;
+}
+
+QImage ZPngWriter::prepareImage(const QImage &image, bool *alpha)
+{
+    *alpha = image.hasAlphaChannel();
+    if (*alpha)
+        return image.convertToFormat(QImage::Format_ARGB32);
+
+    return image.convertToFormat(QImage::Format_RGB32);
+}
+
+// Returns zlib stream pieces: the first one starts with zlib header, the last one
+// ends with adler32 checksum
+QVector<QByteArray> ZPngWriter::deflateStripes(const QImage &image, const QRect &rect, bool alpha, int compression)
+{
+    const int bpp = alpha ? 4 : 3;
+    const int level = qBound(0, compression, maxCompression);
+    const int scanlineSize = rect.width() * bpp + 1;
+
+    const int maxStripes = qMax(1, QThread::idealThreadCount());
+    const int rowsPerStripe = qMax((minStripeBytes + scanlineSize - 1) / scanlineSize,
+                                   (rect.height() + maxStripes - 1) / maxStripes);
+
+    QVector<ZStripe> stripes;
+    for (int top = rect.top(); top <= rect.bottom(); top += rowsPerStripe) {
+        ZStripe stripe;
+        stripe.top = top;
+        stripe.bottom = qMin(top + rowsPerStripe, rect.bottom() + 1);
+        stripes.append(stripe);
+    }
+    if (stripes.isEmpty()) return QVector<QByteArray>();
+
+    // the calling thread takes the first stripe itself
+    QSemaphore done;
+    ZStripe *stripesData = stripes.data();
+    for (int i = 1; i < stripes.count(); i++) {
+        ZStripe *stripe = stripesData + i; // NOLINT
+        const bool last = (i == stripes.count() - 1);
+        threadPool()->start([&image, rect, alpha, level, last, stripe, &done](){
+            deflateStripe(image, rect, alpha, level, last, stripe);
+            done.release();
+        });
+    }
+    deflateStripe(image, rect, alpha, level, stripes.count() == 1, stripesData);
+    done.acquire(stripes.count() - 1);
+
+    QVector<QByteArray> res;
+    uLong adler = adler32(0L, Z_NULL, 0);
+    for (const auto &stripe : std::as_const(stripes)) {
+        if (!stripe.ok) return QVector<QByteArray>();
+        adler = adler32_combine(adler, stripe.adler, static_cast<z_off_t>(stripe.length));
+        res.append(stripe.data);
+    }
+
+    // zlib header: deflate with 32K window, compression level hint
+    const int cmf = 0x78;
+    int flg = 0;
+    if (level >= 7) { // NOLINT
+        flg = 3 << 6; // NOLINT
+    } else if (level == 6) { // NOLINT
+        flg = 2 << 6; // NOLINT
+    } else if (level >= 2) {
+        flg = 1 << 6; // NOLINT
+    }
+    flg += 31 - ((cmf * 256 + flg) % 31); // NOLINT
+
+    res.first().prepend(static_cast<char>(flg)).prepend(static_cast<char>(cmf));
+    appendUInt32(res.last(), static_cast<quint32>(adler));
+
+    return res;
+}
+
+// Complete zlib stream of the filtered rect scanlines
+QByteArray ZPngWriter::deflateRect(const QImage &image, const QRect &rect, int compression)
+{
+    bool alpha = false;
+    const QImage img = prepareImage(image, &alpha);
+
+    QByteArray res;
+    const QVector<QByteArray> pieces = deflateStripes(img, rect.intersected(img.rect()), alpha, compression);
+    for (const auto &piece : pieces)
+        res.append(piece);
+
+    return res;
+}
+
+bool ZPngWriter::write(const QImage &image, const QString &fileName, int compression, QString *error)
+{
+    static const char pngSignature[] = { '\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n' };
+
+    if (image.isNull()) {
+        if (error)
+            *error = QSL("Null image");
+        return false;
+    }
+
+    bool alpha = false;
+    const QImage img = prepareImage(image, &alpha);
+
+    const QVector<QByteArray> pieces = deflateStripes(img, img.rect(), alpha, compression);
+    if (pieces.isEmpty()) {
+        if (error)
+            *error = QSL("zlib compression failed");
+        return false;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+
+    QByteArray header;
+    appendUInt32(header, static_cast<quint32>(img.width()));
+    appendUInt32(header, static_cast<quint32>(img.height()));
+    header.append(static_cast<char>(8)); // bit depth // NOLINT
+    header.append(static_cast<char>(alpha ? 6 : 2)); // color type: RGBA or RGB // NOLINT
+    header.append(3, static_cast<char>(0)); // compression, filter, interlace
+
+    bool res = (file.write(pngSignature, sizeof(pngSignature)) == static_cast<qint64>(sizeof(pngSignature))) &&
+               writeChunk(file, "IHDR", header);
+
+    // one IDAT chunk per stripe
+    for (const auto &piece : pieces) {
+        if (!res) break;
+        res = writeChunk(file, "IDAT", piece);
+    }
+
+    if (res)
+        res = writeChunk(file, "IEND", QByteArray());
+
+    if (!res) {
+        if (error)
+            *error = file.errorString();
+        file.remove();
+        return false;
+    }
+
+    file.close();
+    return true;
+}
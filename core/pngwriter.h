@@ -0,0 +1,30 @@
+#ifndef PNGWRITER_H
+#define PNGWRITER_H
+
+#include <QImage>
+#include <QRect>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QThreadPool>
+
+// Parallel PNG encoder. The image is split into horizontal stripes, each
+// stripe is filtered and deflated on a pool thread (primed with the tail of
+// the previous stripe as dictionary) and the pieces are stitched into one
+// zlib stream, the same way pigz does.
+class ZPngWriter
+{
+private:
+    static QThreadPool* threadPool();
+    static QImage prepareImage(const QImage &image, bool *alpha);
+    static QVector<QByteArray> deflateStripes(const QImage &image, const QRect &rect, bool alpha, int compression);
+
+public:
+    ZPngWriter() = delete;
+
+    static int compressionFromQuality(int quality);
+    static bool write(const QImage &image, const QString &fileName, int compression, QString *error = nullptr);
+    static QByteArray deflateRect(const QImage &image, const QRect &rect, int compression);
+};
+
+#endif // PNGWRITER_H
@@ -0,0 +1,83 @@
+#include <algorithm>
+
+#include "windowindex.h"
+
+ZWindowIndex::ZWindowIndex(const QVector<QRect> &windows)
+    : m_windows(windows)
+{
+    static const int minCellSize = 64;
+    static const int maxGridSize = 32;
+
+    for (const auto &r : std::as_const(m_windows))
+        m_gridRect |= r;
+
+    if (m_gridRect.isEmpty()) return;
+
+    m_cellSize = qMax(minCellSize, (qMax(m_gridRect.width(), m_gridRect.height()) + maxGridSize - 1) / maxGridSize);
+    m_gridColumns = (m_gridRect.width() + m_cellSize - 1) / m_cellSize;
+    const int gridRows = (m_gridRect.height() + m_cellSize - 1) / m_cellSize;
+    m_cells.resize(m_gridColumns * gridRows);
+
+    for (int i = 0; i < m_windows.size(); i++) {
+        const QRect r = m_windows.at(i).translated(-m_gridRect.topLeft());
+        for (int row = r.top() / m_cellSize; row <= r.bottom() / m_cellSize; row++) {
+            for (int column = r.left() / m_cellSize; column <= r.right() / m_cellSize; column++)
+                m_cells[row * m_gridColumns + column].append(i);
+        }
+    }
+}
+
+const QVector<int> &ZWindowIndex::cellWindows(const QPoint &pos) const
+{
+    static const QVector<int> empty;
+
+    if (!m_gridRect.contains(pos)) return empty;
+
+    const QPoint p = pos - m_gridRect.topLeft();
+    return m_cells.at((p.y() / m_cellSize) * m_gridColumns + p.x() / m_cellSize);
+}
+
+int ZWindowIndex::count() const
+{
+    return m_windows.count();
+}
+
+const QRect &ZWindowIndex::window(int index) const
+{
+    return m_windows.at(index);
+}
+
+// Returns the index of the first (=smallest) window containing pos, or -1
+int ZWindowIndex::windowAt(const QPoint &pos) const
+{
+    for (const int i : cellWindows(pos)) {
+        if (m_windows.at(i).contains(pos))
+            return i;
+    }
+    return -1;
+}
+
+// Returns the next-bigger window containing pos, or current if there is none
+int ZWindowIndex::largerWindowAt(const QPoint &pos, int current) const
+{
+    const QVector<int> &cell = cellWindows(pos);
+    for (auto it = std::upper_bound(cell.constBegin(), cell.constEnd(), current);
+         it != cell.constEnd(); ++it) {
+        if (m_windows.at(*it).contains(pos))
+            return *it;
+    }
+    return current;
+}
+
+// Returns the next-smaller window containing pos, or current if there is none
+int ZWindowIndex::smallerWindowAt(const QPoint &pos, int current) const
+{
+    const QVector<int> &cell = cellWindows(pos);
+    for (auto it = std::lower_bound(cell.constBegin(), cell.constEnd(), current);
+         it != cell.constBegin(); ) {
+        --it;
+        if (m_windows.at(*it).contains(pos))
+            return *it;
+    }
+    return current;
+}
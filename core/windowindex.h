@@ -0,0 +1,37 @@
+#ifndef WINDOWINDEX_H
+#define WINDOWINDEX_H
+
+#include <QPoint>
+#include <QRect>
+#include <QVector>
+
+// Hit-test index over a window list sorted by area (smallest first), as built by
+// ZXCBTools::getWindowsRecursive. The list is spread over a coarse grid, every
+// cell keeps the indexes of all windows crossing it in ascending order, so point
+// queries and scope steps only look at windows that may contain the point.
+// Nested windows share the cells of the innermost one, so a query still walks
+// the whole nesting chain under the point, but never the unrelated windows.
+class ZWindowIndex
+{
+private:
+    QVector<QRect> m_windows;
+    QVector<QVector<int> > m_cells;
+    QRect m_gridRect;
+    int m_cellSize { 0 };
+    int m_gridColumns { 0 };
+
+    const QVector<int> &cellWindows(const QPoint &pos) const;
+
+public:
+    ZWindowIndex() = default;
+    explicit ZWindowIndex(const QVector<QRect> &windows);
+
+    int count() const;
+    const QRect &window(int index) const;
+
+    int windowAt(const QPoint &pos) const;
+    int largerWindowAt(const QPoint &pos, int current) const;
+    int smallerWindowAt(const QPoint &pos, int current) const;
+};
+
+#endif // WINDOWINDEX_H
@@ -0,0 +1,520 @@
+#include <QMutexLocker>
+#include <QPair>
+#include <QDebug>
+
+#include <algorithm>
+
+#include "windowtree.h"
+
+ZWindowTree::ZWindowTree(xcb_atom_t wmStateAtom, QObject *parent)
+    : ZAbstractXCBEventListener(parent),
+      m_wmStateAtom(wmStateAtom)
+{
+    const QVector<quint8> eventTypes( { XCB_CREATE_NOTIFY, XCB_DESTROY_NOTIFY, XCB_CONFIGURE_NOTIFY,
+                                        XCB_REPARENT_NOTIFY, XCB_MAP_NOTIFY, XCB_UNMAP_NOTIFY,
+                                        XCB_CIRCULATE_NOTIFY, XCB_GRAVITY_NOTIFY, XCB_PROPERTY_NOTIFY } );
+
+    for (const auto &type : eventTypes)
+        ZXCBTools::addEventListener(this, type);
+
+    m_seedThread = new QThread();
+    m_seedThread->setObjectName(QStringLiteral("ZWindowTreeSeed"));
+
+    m_seedContext = new QObject();
+    m_seedContext->moveToThread(m_seedThread);
+    connect(m_seedThread.data(),&QThread::finished,m_seedContext.data(),&QObject::deleteLater);
+
+    m_seedThread->start();
+
+    // until the roots are seeded, every window is unknown and the callers
+    // fall back to querying the server
+
+    QMutexLocker locker(&m_treeMutex);
+
+    const xcb_setup_t *setup = xcb_get_setup(ZXCBTools::connection(ZXCBTools::instance()));
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(setup);
+    while (it.rem>0) {
+        m_roots.append(it.data->root);
+        xcb_screen_next(&it);
+    }
+
+    for (const auto &root : qAsConst(m_roots))
+        queueSeed(root, XCB_NONE);
+}
+
+ZWindowTree::~ZWindowTree()
+{
+    ZXCBTools::removeEventListener(this);
+
+    // the seeding context is deleted in its own thread on finish
+    m_seedThread->quit();
+    m_seedThread->wait();
+    delete m_seedThread.data();
+}
+
+// Root window properties are changed frequently, and never contain WM_STATE.
+// Property changes are followed on top-level windows only, where clients create
+// their windows and window managers their frames, and on the clients already
+// reparented deeper when the tree is seeded.
+uint32_t ZWindowTree::eventMask(xcb_window_t parent, bool client) const
+{
+    if (parent == XCB_NONE)
+        return XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY;
+
+    if (client || m_roots.contains(parent))
+        return XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_PROPERTY_CHANGE;
+
+    return XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY;
+}
+
+// Queues the subtree query to the seeding thread, which takes all queued
+// subtrees at once. Must be called with the tree mutex locked.
+void ZWindowTree::queueSeed(xcb_window_t window, xcb_window_t parent)
+{
+    const bool idle = m_seedQueue.isEmpty();
+    m_seedQueue.append(qMakePair(window, parent));
+    m_pendingSeeds++;
+
+    if (idle) {
+        QMetaObject::invokeMethod(m_seedContext.data(),[this](){
+            seedQueued();
+        },Qt::QueuedConnection);
+    }
+}
+
+// Seeding thread. The server is queried without the tree mutex held,
+// so the event handler and the tree users never wait for the round trips.
+void ZWindowTree::seedQueued()
+{
+    QVector<ZSeedItem> items;
+    {
+        QMutexLocker locker(&m_treeMutex);
+        items.swap(m_seedQueue);
+    }
+    if (items.isEmpty()) return;
+
+    const ZNodeHash nodes = querySubtrees(items);
+
+    QMutexLocker locker(&m_treeMutex);
+    mergeSubtrees(nodes);
+    m_pendingSeeds -= items.count();
+    replayDeferredEvents();
+}
+
+// Selects structure events for the windows and all their descendants and reads
+// their state, one batch of requests per tree level. Events are selected before
+// each window is queried, so the changes made after the query are reported.
+ZWindowTree::ZNodeHash ZWindowTree::querySubtrees(const QVector<ZSeedItem> &items) const
+{
+    xcb_connection_t* c = ZXCBTools::connection(ZXCBTools::instance());
+
+    ZNodeHash res;
+    QVector<ZSeedItem> level = items;
+    QVector<xcb_get_window_attributes_cookie_t> attsCookies;
+    QVector<xcb_get_geometry_cookie_t> geomCookies;
+    QVector<xcb_get_property_cookie_t> propCookies;
+    QVector<xcb_query_tree_cookie_t> treeCookies;
+    QVector<QPair<xcb_window_t, xcb_get_property_cookie_t> > clientCookies;
+
+    while (!level.isEmpty()) {
+        attsCookies.clear();
+        geomCookies.clear();
+        propCookies.clear();
+        treeCookies.clear();
+        clientCookies.clear();
+        for (const auto &item : qAsConst(level)) {
+            const uint32_t mask = eventMask(item.second, false);
+            xcb_change_window_attributes(c, item.first, XCB_CW_EVENT_MASK, &mask);
+            attsCookies.append(xcb_get_window_attributes_unchecked(c, item.first));
+            geomCookies.append(xcb_get_geometry_unchecked(c, item.first));
+            propCookies.append(xcb_get_property_unchecked(c, 0, item.first, m_wmStateAtom,
+                                                          XCB_GET_PROPERTY_TYPE_ANY, 0, 0));
+            treeCookies.append(xcb_query_tree_unchecked(c, item.first));
+        }
+
+        const QVector<ZSeedItem> current = level;
+        level.clear();
+        for (int i=0;i<current.count();i++) {
+            const xcb_window_t w = current.at(i).first;
+            const xcb_window_t parent = current.at(i).second;
+
+            QScopedPointer<xcb_get_window_attributes_reply_t,QScopedPointerPodDeleter>
+                    atts(xcb_get_window_attributes_reply(c, attsCookies.at(i), nullptr));
+            QScopedPointer<xcb_get_geometry_reply_t,QScopedPointerPodDeleter>
+                    geom(xcb_get_geometry_reply(c, geomCookies.at(i), nullptr));
+            QScopedPointer<xcb_get_property_reply_t,QScopedPointerPodDeleter>
+                    prop(xcb_get_property_reply(c, propCookies.at(i), nullptr));
+            QScopedPointer<xcb_query_tree_reply_t,QScopedPointerPodDeleter>
+                    tree(xcb_query_tree_reply(c, treeCookies.at(i), nullptr));
+
+            // destroyed while we were looking
+            if (atts.isNull() || geom.isNull()) continue;
+
+            ZWindowNode node;
+            node.parent = parent;
+            node.geometry = QRect(geom->x, geom->y, geom->width, geom->height);
+            node.borderWidth = geom->border_width;
+            node.mapped = (atts->map_state != XCB_MAP_STATE_UNMAPPED);
+            node.client = (prop && prop->type != XCB_NONE);
+
+            // WM_STATE is read again after selecting its changes, it may be
+            // gone before the selection took effect
+            if (node.client && (eventMask(parent, false) != eventMask(parent, true))) {
+                const uint32_t mask = eventMask(parent, true);
+                xcb_change_window_attributes(c, w, XCB_CW_EVENT_MASK, &mask);
+                clientCookies.append(qMakePair(w, xcb_get_property_unchecked(c, 0, w, m_wmStateAtom,
+                                                                             XCB_GET_PROPERTY_TYPE_ANY, 0, 0)));
+            }
+
+            if (tree) {
+                xcb_window_t* child = xcb_query_tree_children(tree.data());
+                for (unsigned int j=0;j<tree->children_len;j++) {
+                    node.children.append(child[j]); // NOLINT
+                    level.append(qMakePair(child[j], w)); // NOLINT
+                }
+            }
+
+            res.insert(w, node);
+        }
+
+        for (const auto &item : qAsConst(clientCookies)) {
+            QScopedPointer<xcb_get_property_reply_t,QScopedPointerPodDeleter>
+                    prop(xcb_get_property_reply(c, item.second, nullptr));
+            res[item.first].client = (prop && prop->type != XCB_NONE);
+        }
+    }
+
+    xcb_flush(c);
+    return res;
+}
+
+// Adds the queried windows not known yet. Windows known meanwhile from
+// events are newer than the query and stay as they are, only the newly
+// added children are linked to them. Their WM_STATE comes from the query
+// though, unless a property event reported it: CreateNotify doesn't carry
+// it, and the change is not reported before the seed selects it.
+// Must be called with the tree mutex locked.
+void ZWindowTree::mergeSubtrees(const ZNodeHash &nodes)
+{
+    QVector<xcb_window_t> added;
+    for (auto it = nodes.constBegin(), end = nodes.constEnd(); it != end; ++it) {
+        auto existing = m_nodes.find(it.key());
+        if (existing != m_nodes.end()) {
+            if (!existing.value().clientFromEvent)
+                existing.value().client = it.value().client;
+            continue;
+        }
+
+        m_nodes.insert(it.key(), it.value());
+        added.append(it.key());
+    }
+
+    for (const auto &window : qAsConst(added)) {
+        auto it = m_nodes.find(window);
+
+        // children destroyed or moved away meanwhile are dropped
+        QVector<xcb_window_t> &children = it.value().children;
+        children.erase(std::remove_if(children.begin(), children.end(), [this,window](xcb_window_t child){
+            auto cit = m_nodes.constFind(child);
+            return (cit == m_nodes.constEnd() || cit.value().parent != window);
+        }), children.end());
+
+        auto pit = m_nodes.find(it.value().parent);
+        if (pit != m_nodes.end() && !pit.value().children.contains(window))
+            pit.value().children.append(window);
+    }
+}
+
+// Applies the events deferred for unknown windows, in their original order.
+// Must be called with the tree mutex locked.
+void ZWindowTree::replayDeferredEvents()
+{
+    QVector<xcb_generic_event_t> events;
+    events.swap(m_deferredEvents);
+
+    for (const auto &event : qAsConst(events)) {
+        if (!applyEvent(&event) && (m_pendingSeeds > 0))
+            m_deferredEvents.append(event);
+    }
+}
+
+// Inserts the window into the parent stacking list above the sibling.
+// No sibling places it at the bottom, unknown sibling - on the top.
+void ZWindowTree::addChild(xcb_window_t parent, xcb_window_t window, xcb_window_t above)
+{
+    auto it = m_nodes.find(parent);
+    if (it == m_nodes.end()) return;
+
+    QVector<xcb_window_t> &children = it.value().children;
+    children.removeOne(window);
+
+    if (above == XCB_NONE) {
+        children.prepend(window);
+    } else {
+        const int idx = children.indexOf(above);
+        if (idx < 0) {
+            children.append(window);
+        } else {
+            children.insert(idx + 1, window);
+        }
+    }
+}
+
+void ZWindowTree::removeChild(xcb_window_t parent, xcb_window_t window)
+{
+    auto it = m_nodes.find(parent);
+    if (it != m_nodes.end())
+        it.value().children.removeOne(window);
+}
+
+void ZWindowTree::removeWindow(xcb_window_t window)
+{
+    auto it = m_nodes.find(window);
+    if (it == m_nodes.end()) return;
+
+    const ZWindowNode node = it.value();
+    m_nodes.erase(it);
+
+    removeChild(node.parent, window);
+    for (const auto &child : node.children)
+        removeWindow(child);
+}
+
+bool ZWindowTree::isViewable(xcb_window_t window) const
+{
+    for (auto it = m_nodes.constFind(window); it != m_nodes.constEnd(); it = m_nodes.constFind(it.value().parent)) {
+        if (!it.value().mapped)
+            return false;
+        if (it.value().parent == XCB_NONE)
+            return true;
+    }
+    return false;
+}
+
+QPoint ZWindowTree::rootOrigin(xcb_window_t window) const
+{
+    QPoint res;
+    for (auto it = m_nodes.constFind(window); it != m_nodes.constEnd(); it = m_nodes.constFind(it.value().parent)) {
+        if (it.value().parent == XCB_NONE)
+            break;
+        res += it.value().geometry.topLeft() + QPoint(it.value().borderWidth, it.value().borderWidth);
+    }
+    return res;
+}
+
+// Same as ZXCBTools::getWindowsRecursive, but from the cached tree.
+// Returns false if the window is unknown.
+bool ZWindowTree::collectWindows(QVector<QRect> &windows, xcb_window_t window, int rx, int ry, int depth,
+                                 int minSize)
+{
+    struct ZWindowItem {
+        xcb_window_t window;
+        int rx;
+        int ry;
+        int depth;
+    };
+
+    QMutexLocker locker(&m_treeMutex);
+
+    if (!m_nodes.contains(window)) return false;
+    if (!isViewable(window)) return true;
+
+    QVector<ZWindowItem> stack( { { window, rx, ry, depth } } );
+    while (!stack.isEmpty()) {
+        const ZWindowItem item = stack.takeLast();
+
+        auto it = m_nodes.constFind(item.window);
+        if (it == m_nodes.constEnd()) continue;
+
+        const ZWindowNode &node = it.value();
+        if (!node.mapped || node.geometry.width() < minSize || node.geometry.height() < minSize)
+            continue;
+
+        int x = 0;
+        int y = 0;
+        if ( item.depth != 0 ) {
+            x = node.geometry.x() + item.rx;
+            y = node.geometry.y() + item.ry;
+        }
+
+        QRect r( x, y, node.geometry.width(), node.geometry.height() );
+        if (!windows.contains(r))
+            windows.append(r);
+
+        for (const auto &child : node.children)
+            stack.append(ZWindowItem { child, x, y, item.depth + 1 });
+    }
+
+    return true;
+}
+
+// Same as ZXCBTools::findRealWindow, but from the cached tree.
+// Returns false if the window is unknown.
+bool ZWindowTree::findClient(xcb_window_t window, int maxDepth, xcb_window_t *client)
+{
+    QMutexLocker locker(&m_treeMutex);
+
+    if (!m_nodes.contains(window)) return false;
+
+    *client = XCB_NONE;
+    QVector<xcb_window_t> level( { window } );
+    QVector<xcb_window_t> next;
+    for (int d = 0; (d <= maxDepth) && !level.isEmpty(); d++) {
+        next.clear();
+        for (const auto &w : qAsConst(level)) {
+            auto it = m_nodes.constFind(w);
+            if (it == m_nodes.constEnd()) continue;
+
+            if (it.value().client) {
+                *client = w;
+                return true;
+            }
+            next.append(it.value().children);
+        }
+        level.swap(next);
+    }
+
+    return true;
+}
+
+// Returns outer window geometry in root window coordinates,
+// or null rect if the window is unknown.
+QRect ZWindowTree::rootGeometry(xcb_window_t window)
+{
+    QMutexLocker locker(&m_treeMutex);
+
+    auto it = m_nodes.constFind(window);
+    if (it == m_nodes.constEnd()) return QRect();
+
+    return QRect(rootOrigin(it.value().parent) + it.value().geometry.topLeft(),
+                 it.value().geometry.size());
+}
+
+// Events for windows not known yet are kept while some subtree is being
+// queried, the window may be part of it
+void ZWindowTree::nativeEventHandler(const xcb_generic_event_t *event)
+{
+    QMutexLocker locker(&m_treeMutex);
+
+    if (!applyEvent(event) && (m_pendingSeeds > 0))
+        m_deferredEvents.append(*event);
+}
+
+// Returns false if the event refers to an unknown window.
+// Must be called with the tree mutex locked.
+bool ZWindowTree::applyEvent(const xcb_generic_event_t *event)
+{
+    const unsigned short responseMask = 0x7f;
+
+    switch (event->response_type & responseMask) {
+        case XCB_CREATE_NOTIFY: {
+            const auto *ev = reinterpret_cast<const xcb_create_notify_event_t *>(event);
+            auto pit = m_nodes.find(ev->parent);
+            if (pit == m_nodes.end()) return false;
+            if (m_nodes.contains(ev->window)) break;
+
+            // new windows are unmapped and created on top of their siblings,
+            // children may have been created before our event selection
+            pit.value().children.append(ev->window);
+
+            ZWindowNode node;
+            node.parent = ev->parent;
+            node.geometry = QRect(ev->x, ev->y, ev->width, ev->height);
+            node.borderWidth = ev->border_width;
+            m_nodes.insert(ev->window, node);
+
+            queueSeed(ev->window, ev->parent);
+            break;
+        }
+        case XCB_DESTROY_NOTIFY: {
+            const auto *ev = reinterpret_cast<const xcb_destroy_notify_event_t *>(event);
+            if (!m_nodes.contains(ev->window)) return false;
+
+            removeWindow(ev->window);
+            break;
+        }
+        case XCB_CONFIGURE_NOTIFY: {
+            const auto *ev = reinterpret_cast<const xcb_configure_notify_event_t *>(event);
+            auto it = m_nodes.find(ev->window);
+            if (it == m_nodes.end()) return false;
+
+            it.value().geometry = QRect(ev->x, ev->y, ev->width, ev->height);
+            it.value().borderWidth = ev->border_width;
+            addChild(it.value().parent, ev->window, ev->above_sibling);
+            break;
+        }
+        case XCB_REPARENT_NOTIFY: {
+            // delivered to both old and new parent
+            const auto *ev = reinterpret_cast<const xcb_reparent_notify_event_t *>(event);
+            auto it = m_nodes.find(ev->window);
+            if (it == m_nodes.end()) return false;
+
+            it.value().geometry.moveTo(ev->x, ev->y);
+            if (it.value().parent == ev->parent) break;
+
+            if (!m_nodes.contains(ev->parent)) {
+                removeWindow(ev->window);
+                break;
+            }
+            removeChild(it.value().parent, ev->window);
+            it.value().parent = ev->parent;
+            m_nodes[ev->parent].children.append(ev->window);
+            break;
+        }
+        case XCB_MAP_NOTIFY: {
+            const auto *ev = reinterpret_cast<const xcb_map_notify_event_t *>(event);
+            auto it = m_nodes.find(ev->window);
+            if (it == m_nodes.end()) return false;
+
+            it.value().mapped = true;
+            break;
+        }
+        case XCB_UNMAP_NOTIFY: {
+            const auto *ev = reinterpret_cast<const xcb_unmap_notify_event_t *>(event);
+            auto it = m_nodes.find(ev->window);
+            if (it == m_nodes.end()) return false;
+
+            it.value().mapped = false;
+            break;
+        }
+        case XCB_CIRCULATE_NOTIFY: {
+            const auto *ev = reinterpret_cast<const xcb_circulate_notify_event_t *>(event);
+            auto it = m_nodes.find(ev->window);
+            if (it == m_nodes.end()) return false;
+
+            auto pit = m_nodes.find(it.value().parent);
+            if (pit == m_nodes.end()) break;
+
+            pit.value().children.removeOne(ev->window);
+            if (ev->place == XCB_PLACE_ON_TOP) {
+                pit.value().children.append(ev->window);
+            } else {
+                pit.value().children.prepend(ev->window);
+            }
+            break;
+        }
+        case XCB_GRAVITY_NOTIFY: {
+            const auto *ev = reinterpret_cast<const xcb_gravity_notify_event_t *>(event);
+            auto it = m_nodes.find(ev->window);
+            if (it == m_nodes.end()) return false;
+
+            it.value().geometry.moveTo(ev->x, ev->y);
+            break;
+        }
+        case XCB_PROPERTY_NOTIFY: {
+            const auto *ev = reinterpret_cast<const xcb_property_notify_event_t *>(event);
+            if (ev->atom != m_wmStateAtom) break;
+
+            auto it = m_nodes.find(ev->window);
+            if (it == m_nodes.end()) return false;
+
+            it.value().client = (ev->state == XCB_PROPERTY_NEW_VALUE);
+            it.value().clientFromEvent = true;
+            break;
+        }
+        default:
+            break;
+    }
+
+    return true;
+}
@@ -0,0 +1,78 @@
+#ifndef WINDOWTREE_H
+#define WINDOWTREE_H
+
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QRect>
+#include <QMutex>
+#include <QPair>
+#include <QPointer>
+#include <QThread>
+
+#include "xcbtools.h"
+
+// In-memory copy of the X window tree. Kept current by structure and WM_STATE
+// property events, so window picking does not need any round trips to the X server.
+// The event handler never waits for the server: new windows are inserted from
+// the CreateNotify fields, and subtrees (initially the roots, then the children
+// created before our event selection) are queried with batched requests on
+// a seeding thread. Events for windows not known yet are deferred until the
+// queried subtrees are merged, then replayed over them.
+class ZWindowTree : public ZAbstractXCBEventListener
+{
+    Q_OBJECT
+private:
+    Q_DISABLE_COPY(ZWindowTree)
+
+    struct ZWindowNode {
+        xcb_window_t parent { XCB_NONE };
+        QRect geometry; // relative to parent, without border
+        int borderWidth { 0 };
+        bool mapped { false };
+        bool client { false }; // has WM_STATE property
+        bool clientFromEvent { false }; // WM_STATE change seen, newer than any seed
+        QVector<xcb_window_t> children; // in stacking order, bottom first
+    };
+
+    using ZSeedItem = QPair<xcb_window_t, xcb_window_t>; // window, parent
+    using ZNodeHash = QHash<xcb_window_t, ZWindowNode>;
+
+    QMutex m_treeMutex;
+    ZNodeHash m_nodes;
+    QVector<ZSeedItem> m_seedQueue;
+    QVector<xcb_generic_event_t> m_deferredEvents;
+    int m_pendingSeeds { 0 };
+    QVector<xcb_window_t> m_roots; // constant after construction
+    xcb_atom_t m_wmStateAtom { XCB_NONE };
+
+    QPointer<QThread> m_seedThread;
+    QPointer<QObject> m_seedContext;
+
+    void queueSeed(xcb_window_t window, xcb_window_t parent);
+    void seedQueued();
+    ZNodeHash querySubtrees(const QVector<ZSeedItem> &items) const;
+    void mergeSubtrees(const ZNodeHash &nodes);
+    void replayDeferredEvents();
+    bool applyEvent(const xcb_generic_event_t *event);
+    uint32_t eventMask(xcb_window_t parent, bool client) const;
+    void addChild(xcb_window_t parent, xcb_window_t window, xcb_window_t above);
+    void removeChild(xcb_window_t parent, xcb_window_t window);
+    void removeWindow(xcb_window_t window);
+    bool isViewable(xcb_window_t window) const;
+    QPoint rootOrigin(xcb_window_t window) const;
+
+public:
+    ZWindowTree(xcb_atom_t wmStateAtom, QObject* parent = nullptr);
+    ~ZWindowTree() override;
+
+    bool collectWindows(QVector<QRect> &windows, xcb_window_t window, int rx, int ry, int depth, int minSize);
+    bool findClient(xcb_window_t window, int maxDepth, xcb_window_t *client);
+    QRect rootGeometry(xcb_window_t window);
+
+protected:
+    void nativeEventHandler(const xcb_generic_event_t* event) override;
+
+};
+
+#endif // WINDOWTREE_H
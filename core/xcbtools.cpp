@@ -0,0 +1,942 @@
+#include <QPointer>
+#include <QSharedPointer>
+#include <QMutex>
+#include <QCursor>
+#include <QPoint>
+#include <QPainter>
+#include <QScreen>
+#include <QCoreApplication>
+#include <QKeySequence>
+#include <QDebug>
+
+#include <algorithm>
+#include <atomic>
+#include <X11/keysym.h>
+
+#include "xcbtools.h"
+#include "captureworker.h"
+#include "windowtree.h"
+#include "cursorcache.h"
+#include "keysymcache.h"
+
+static const int minSize = 8;
+static const int listenerTableSize = 128;
+static const unsigned short responseMask = 0x7f;
+
+ZXCBTools::ZXCBTools(QObject *parent)
+    : QObject(parent)
+{
+    const char *closeAtom = "_ZXCB_CLOSE_CONNECTION";
+    const char *wmStateAtom = "WM_STATE";
+
+    m_connection = xcb_connect(nullptr, nullptr);
+    int res = xcb_connection_has_error(m_connection);
+    if (res>0) {
+        qCritical() << "Error in XCB connection " << res;
+        return;
+    }
+
+    xcb_intern_atom_cookie_t ac = xcb_intern_atom(m_connection, 0, strlen(closeAtom), closeAtom);
+    xcb_intern_atom_cookie_t wc = xcb_intern_atom(m_connection, 0, strlen(wmStateAtom), wmStateAtom);
+    QScopedPointer<xcb_intern_atom_reply_t,QScopedPointerPodDeleter>
+            acr(xcb_intern_atom_reply(m_connection, ac, nullptr));
+    if (acr)
+        m_closeAtom = acr->atom;
+    QScopedPointer<xcb_intern_atom_reply_t,QScopedPointerPodDeleter>
+            wcr(xcb_intern_atom_reply(m_connection, wc, nullptr));
+    if (wcr)
+        m_wmStateAtom = wcr->atom;
+
+    initDamage();
+    initXFixes();
+    startCaptureThread();
+
+    m_eventLoopThread = createEventLoop();
+    connect(m_eventLoopThread.data(),&QThread::finished,m_eventLoopThread.data(),&QThread::deleteLater);
+    m_eventLoopThread->setObjectName(QStringLiteral("ZXCBTools"));
+    m_eventLoopThread->start();
+}
+
+ZXCBTools::~ZXCBTools()
+{
+    // these listeners unregister themselves from us, so they must go first
+    if (m_windowTree)
+        delete m_windowTree.data();
+    if (m_cursorCache)
+        delete m_cursorCache.data();
+    if (m_keySymbols)
+        delete m_keySymbols.data();
+
+    if (m_eventLoopThread)
+        exitEventLoop();
+
+    stopCaptureThread();
+    xcb_disconnect(m_connection);
+
+    delete m_listenerTable.fetchAndStoreOrdered(nullptr);
+    qDeleteAll(m_retiredTables);
+}
+
+void ZXCBTools::startCaptureThread()
+{
+    m_captureThread = new QThread();
+    m_captureThread->setObjectName(QStringLiteral("ZXCBCapture"));
+
+    m_captureWorker = new ZCaptureWorker();
+    m_captureWorker->moveToThread(m_captureThread);
+    connect(m_captureThread.data(),&QThread::finished,m_captureWorker.data(),&QObject::deleteLater);
+
+    m_captureThread->start();
+}
+
+void ZXCBTools::stopCaptureThread()
+{
+    if (m_captureThread.isNull()) return;
+
+    // the worker is deleted in its own thread on finish
+    m_captureThread->quit();
+    m_captureThread->wait();
+    delete m_captureThread.data();
+}
+
+// Queues the grab to the capture thread and waits for the result.
+// Called from the capture thread itself, runs the grab directly.
+template<typename Func>
+QImage ZXCBTools::runCapture(Func grab)
+{
+    auto* inst = ZXCBTools::instance();
+    QPointer<ZCaptureWorker> worker = inst->m_captureWorker;
+    if (worker.isNull()) return QImage();
+
+    if (QThread::currentThread() == inst->m_captureThread.data())
+        return grab(worker.data());
+
+    QImage res;
+    QMetaObject::invokeMethod(worker.data(),[worker,grab](){
+        return grab(worker.data());
+    },Qt::BlockingQueuedConnection,&res);
+
+    return res;
+}
+
+// Queues the grab to the capture thread without waiting for it. The callback
+// runs later in the thread of context, or never when context is destroyed first.
+template<typename Func>
+void ZXCBTools::queueCapture(Func grab, QObject *context, const ZImageCallback &callback)
+{
+    auto* inst = ZXCBTools::instance();
+    QPointer<ZCaptureWorker> worker = inst->m_captureWorker;
+    if (worker.isNull()) {
+        QMetaObject::invokeMethod(context,[callback](){
+            callback(QImage());
+        },Qt::QueuedConnection);
+        return;
+    }
+
+    // The connection keeps the relay until the result is delivered or the context is
+    // destroyed. Whichever thread drops the last reference, the relay is deleted in its own.
+    QSharedPointer<ZCaptureRelay> relay(new ZCaptureRelay(),&QObject::deleteLater);
+    connect(relay.data(),&ZCaptureRelay::captured,context,[relay,callback](){
+        relay->disconnect();
+        callback(relay->takeImage());
+    },Qt::QueuedConnection);
+
+    QMetaObject::invokeMethod(worker.data(),[worker,grab,relay](){
+        relay->setImage(grab(worker.data()));
+        Q_EMIT relay->captured();
+    },Qt::QueuedConnection);
+}
+
+void ZXCBTools::initDamage()
+{
+    const xcb_query_extension_reply_t* ext = xcb_get_extension_data(m_connection, &xcb_damage_id);
+    if ((ext == nullptr) || (ext->present == 0U)) {
+        qInfo() << "XCB DAMAGE extension not available, autocapture will use scan timer";
+        return;
+    }
+
+    // the client must negotiate version before any other damage request
+    xcb_damage_query_version_cookie_t vc = xcb_damage_query_version(m_connection,
+                                                                     XCB_DAMAGE_MAJOR_VERSION,
+                                                                     XCB_DAMAGE_MINOR_VERSION);
+    QScopedPointer<xcb_damage_query_version_reply_t,QScopedPointerPodDeleter>
+            vr(xcb_damage_query_version_reply(m_connection, vc, nullptr));
+
+    if (vr)
+        m_damageEventBase = ext->first_event;
+}
+
+void ZXCBTools::initXFixes()
+{
+    const xcb_query_extension_reply_t* ext = xcb_get_extension_data(m_connection, &xcb_xfixes_id);
+    if ((ext == nullptr) || (ext->present == 0U)) {
+        qInfo() << "XCB XFIXES extension not available, pointer will not be captured";
+        return;
+    }
+
+    xcb_xfixes_query_version_cookie_t vc = xcb_xfixes_query_version(m_connection,
+                                                                     XCB_XFIXES_MAJOR_VERSION,
+                                                                     XCB_XFIXES_MINOR_VERSION);
+    QScopedPointer<xcb_xfixes_query_version_reply_t,QScopedPointerPodDeleter>
+            vr(xcb_xfixes_query_version_reply(m_connection, vc, nullptr));
+
+    if (vr)
+        m_xfixesEventBase = ext->first_event;
+}
+
+// Returns the cache, creating it on first use. The cache is constructed without
+// the caches mutex held, as the constructors register event listeners and the
+// handlers may use other caches. A thread losing the race deletes its copy.
+template<typename T, typename Func>
+T* ZXCBTools::sharedCache(QPointer<T> &cache, Func create)
+{
+    auto* inst = ZXCBTools::instance();
+    {
+        QMutexLocker locker(&(inst->m_cachesMutex));
+        if (!cache.isNull())
+            return cache.data();
+    }
+
+    T* created = create(inst);
+
+    T* res = nullptr;
+    {
+        QMutexLocker locker(&(inst->m_cachesMutex));
+        if (cache.isNull())
+            cache = created;
+        res = cache.data();
+    }
+
+    if (res != created)
+        delete created;
+
+    return res;
+}
+
+// Cursor image cache is created on first use
+ZCursorCache *ZXCBTools::cursorCache()
+{
+    return sharedCache(ZXCBTools::instance()->m_cursorCache, [](ZXCBTools* inst){
+        return new ZCursorCache(inst->m_xfixesEventBase, inst);
+    });
+}
+
+quint8 ZXCBTools::damageEventBase()
+{
+    return ZXCBTools::instance()->m_damageEventBase;
+}
+
+// One receiver can listen for several response types, one call per type
+void ZXCBTools::addEventListener(ZAbstractXCBEventListener *receiver, quint8 responseType)
+{
+    auto* inst = ZXCBTools::instance();
+    const ZListenerTable *old = nullptr;
+    {
+        QMutexLocker locker(&(inst->m_listenersMutex));
+        if (inst->m_eventListeners.contains(receiver,responseType)) return;
+
+        inst->m_eventListeners.insert(receiver,responseType);
+        old = inst->publishListeners();
+    }
+    inst->retireListeners(old);
+}
+
+// A removed listener is never called after this returns, also when a handler
+// removes it in the middle of a dispatch
+void ZXCBTools::removeEventListener(ZAbstractXCBEventListener *receiver)
+{
+    auto* inst = ZXCBTools::instance();
+    const ZListenerTable *old = nullptr;
+    {
+        QMutexLocker locker(&(inst->m_listenersMutex));
+        if (inst->m_eventListeners.remove(receiver) == 0) return;
+
+        old = inst->publishListeners();
+    }
+    inst->retireListeners(old);
+}
+
+// Builds a new immutable dispatch table indexed by response type and swaps it in.
+// Returns the old table for retireListeners().
+// Must be called with the listeners mutex locked.
+const ZXCBTools::ZListenerTable *ZXCBTools::publishListeners()
+{
+    auto *table = new ZListenerTable(listenerTableSize);
+    for (auto it = m_eventListeners.constKeyValueBegin(), end = m_eventListeners.constKeyValueEnd();
+         it != end; ++it) {
+        (*table)[(*it).second & responseMask].append((*it).first);
+    }
+
+    return m_listenerTable.fetchAndStoreOrdered(table);
+}
+
+// Frees the old table after the dispatch in progress, if any, is finished.
+// Called without the listeners mutex, so other writers are not held up while
+// this one waits for the dispatch.
+void ZXCBTools::retireListeners(const ZListenerTable *table)
+{
+    if (table == nullptr) return;
+
+    // listener called from the event loop thread itself must not wait for
+    // its own dispatch, the table is freed when the dispatch returns
+    if (QThread::currentThread() == m_eventLoopThread.data()) {
+        m_retiredTables.append(table);
+        return;
+    }
+
+    // the sequence is odd while dispatch is in progress
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int sequence = m_dispatchSequence.loadAcquire();
+    if ((sequence & 1) != 0) {
+        while (m_dispatchSequence.loadAcquire() == sequence)
+            QThread::yieldCurrentThread();
+    }
+
+    delete table;
+}
+
+// Window tree cache is seeded on first use
+ZWindowTree *ZXCBTools::windowTree()
+{
+    return sharedCache(ZXCBTools::instance()->m_windowTree, [](ZXCBTools* inst){
+        return new ZWindowTree(inst->m_wmStateAtom, inst);
+    });
+}
+
+// Keyboard mapping cache, shared by all threads. It is downloaded on first use
+ZKeySymbolsCache *ZXCBTools::keySymbols()
+{
+    return sharedCache(ZXCBTools::instance()->m_keySymbols, [](ZXCBTools* inst){
+        return new ZKeySymbolsCache(inst);
+    });
+}
+
+QThread* ZXCBTools::createEventLoop()
+{
+    QThread* res = QThread::create([this](){
+        for (;;) {
+            QScopedPointer<xcb_generic_event_t,QScopedPointerPodDeleter> event
+                    (xcb_wait_for_event(m_connection));
+
+            if (event.isNull()) break;
+            const quint8 responseType = event->response_type & responseMask;
+
+            // exit loop on client message with our exit-atom
+            if (responseType == XCB_CLIENT_MESSAGE) {
+                const auto *clientMessage = reinterpret_cast<const xcb_client_message_event_t *>(event.data());
+                if (clientMessage->type == m_closeAtom)
+                    return;
+            }
+
+            m_dispatchSequence.fetchAndAddOrdered(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            const ZListenerTable *table = m_listenerTable.loadAcquire();
+            if (table) {
+                for (auto *listener : table->at(responseType)) {
+                    // a handler has changed the listeners during this dispatch, skip
+                    // the ones it removed, they may be deleted already. Tables live
+                    // until the dispatch returns, so the live one is safe to read
+                    if (!m_retiredTables.isEmpty()) {
+                        const ZListenerTable *live = m_listenerTable.loadAcquire();
+                        if (!live->at(responseType).contains(listener)) continue;
+                    }
+                    listener->nativeEventHandler(event.data());
+                }
+            }
+
+            m_dispatchSequence.fetchAndAddOrdered(1);
+
+            if (!m_retiredTables.isEmpty()) {
+                qDeleteAll(m_retiredTables);
+                m_retiredTables.clear();
+            }
+        }
+    });
+    return res;
+}
+
+void ZXCBTools::exitEventLoop()
+{
+    if (m_eventLoopThread.isNull()) return;
+
+    // A hack to close XCB connection. Apparently XCB does not have any APIs for this?
+    xcb_client_message_event_t event {};
+    memset(&event, 0, sizeof(event));
+    const xcb_setup_t* setup = xcb_get_setup(m_connection);
+    const xcb_window_t window = xcb_generate_id(m_connection);
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(setup);
+
+    if (it.rem>0) {
+        const unsigned short msgFormat = 32; // undocumented by XCB
+        xcb_screen_t *screen = it.data;
+        xcb_create_window(m_connection, XCB_COPY_FROM_PARENT,
+                          window, screen->root,
+                          0, 0, 1, 1, 0, XCB_WINDOW_CLASS_INPUT_ONLY,
+                          screen->root_visual, 0, nullptr);
+        event.response_type = XCB_CLIENT_MESSAGE;
+        event.format = msgFormat;
+        event.sequence = 0;
+        event.window = window;
+        event.type = m_closeAtom;
+        event.data.data32[0] = 0;
+        xcb_send_event(m_connection, 0, window, XCB_EVENT_MASK_NO_EVENT, reinterpret_cast<const char *>(&event));
+        xcb_destroy_window(m_connection, window);
+        xcb_flush(m_connection);
+    } else {
+        qCritical() << "Unable to stop auxiliary XCB event loop in order. Aborting XCB aux thread by force.";
+        m_eventLoopThread->terminate();
+    }
+
+    // Wait for event thread termination
+    m_eventLoopThread->wait();
+}
+
+ZXCBTools *ZXCBTools::instance()
+{
+    static QPointer<ZXCBTools> inst;
+    static QMutex instMutex;
+
+    instMutex.lock();
+
+    if (inst.isNull())
+        inst = new ZXCBTools(QCoreApplication::instance());
+
+    instMutex.unlock();
+
+    return inst.data();
+}
+
+xcb_connection_t *ZXCBTools::connection(ZXCBTools* inst)
+{
+    return inst->m_connection;
+}
+
+xcb_window_t ZXCBTools::appRootWindow()
+{
+    xcb_connection_t *c = connection(ZXCBTools::instance());
+    const xcb_setup_t *setup = xcb_get_setup(c);
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(setup);
+
+    while (it.rem>0) {
+        xcb_window_t root = it.data->root;
+        xcb_query_pointer_cookie_t pc = xcb_query_pointer(c, root);
+        QScopedPointer<xcb_query_pointer_reply_t,QScopedPointerPodDeleter>
+                pr(xcb_query_pointer_reply(c, pc, nullptr));
+        if ((pr != nullptr) && (pr->same_screen > 0))
+            return root;
+
+        xcb_screen_next(&it);
+    }
+
+    return 0;
+}
+
+QRect ZXCBTools::getWindowGeometry(xcb_window_t window)
+{
+    QRect res;
+
+    xcb_connection_t *xcbConn = connection(ZXCBTools::instance());
+
+    xcb_get_geometry_cookie_t geomCookie = xcb_get_geometry_unchecked(xcbConn, window);
+    QScopedPointer<xcb_get_geometry_reply_t,QScopedPointerPodDeleter>
+            geomReply(xcb_get_geometry_reply(xcbConn,geomCookie, nullptr));
+
+    if (geomReply)
+        res = QRect(geomReply->x,geomReply->y,geomReply->width,geomReply->height);
+
+    return res;
+}
+
+// Returns a view into the persistent capture buffer. While the view is alive
+// the buffer grabs into other memory, so keeping it only costs that memory.
+QImage ZXCBTools::getWindowImage(xcb_window_t window)
+{
+    return runCapture([window](ZCaptureWorker* worker){
+        return worker->grabWindow(window);
+    });
+}
+
+// Requests only the root-relative rect from the server. Like getWindowImage,
+// returns a view into the persistent capture buffer.
+QImage ZXCBTools::getRootImage(const QRect &rect)
+{
+    const xcb_window_t root = appRootWindow();
+    const QRect geom = rect.intersected(getWindowGeometry(root));
+    if (geom.isEmpty()) return QImage();
+
+    return runCapture([root,geom](ZCaptureWorker* worker){
+        return worker->grabArea(root, geom);
+    });
+}
+
+void ZXCBTools::requestWindowImage(xcb_window_t window, QObject *context,
+                                   const ZImageCallback &callback)
+{
+    queueCapture([window](ZCaptureWorker* worker){
+        return worker->grabWindow(window);
+    },context,callback);
+}
+
+// Asynchronous getRootImage, the GUI thread keeps running during the transfer
+void ZXCBTools::requestRootImage(const QRect &rect, QObject *context,
+                                 const ZImageCallback &callback)
+{
+    const xcb_window_t root = appRootWindow();
+    const QRect geom = rect.intersected(getWindowGeometry(root));
+    if (geom.isEmpty()) {
+        QMetaObject::invokeMethod(context,[callback](){
+            callback(QImage());
+        },Qt::QueuedConnection);
+        return;
+    }
+
+    queueCapture([root,geom](ZCaptureWorker* worker){
+        return worker->grabArea(root, geom);
+    },context,callback);
+}
+
+QPixmap ZXCBTools::getRootPixmap(const QRect &rect, bool blendPointer)
+{
+    return rootImageToPixmap(getRootImage(rect), rect, blendPointer);
+}
+
+// Converts an image grabbed by getRootImage(rect) to a pixmap, blending in the pointer.
+// The image is taken by value, so a frame passed as a temporary is painted in place.
+QPixmap ZXCBTools::rootImageToPixmap(QImage image, const QRect &rect, bool blendPointer)
+{
+    if (blendPointer && !image.isNull()) {
+        // root geometry always starts at the origin, so the clipped rect does too
+        blendCursorImage(image, qMax(rect.x(), 0), qMax(rect.y(), 0));
+    }
+
+    return QPixmap::fromImage(image);
+}
+
+QPixmap ZXCBTools::getWindowPixmap(xcb_window_t window, bool blendPointer)
+{
+    return windowImageToPixmap(getWindowImage(window), window, blendPointer);
+}
+
+// Converts an image grabbed by getWindowImage(window) to a pixmap, blending in the pointer
+QPixmap ZXCBTools::windowImageToPixmap(QImage nativeImage, xcb_window_t window, bool blendPointer)
+{
+    if (!(blendPointer) || nativeImage.isNull())
+        return QPixmap::fromImage(nativeImage);
+
+    xcb_connection_t *xcbConn = connection(ZXCBTools::instance());
+
+    xcb_get_geometry_cookie_t geomCookie = xcb_get_geometry_unchecked(xcbConn, window);
+    QScopedPointer<xcb_get_geometry_reply_t,QScopedPointerPodDeleter>
+            geomReply(xcb_get_geometry_reply(xcbConn, geomCookie, nullptr));
+
+    if (geomReply.isNull())
+        return QPixmap::fromImage(nativeImage);
+
+    // now we blend in a pointer image
+
+    xcb_get_geometry_cookie_t geomRootCookie = xcb_get_geometry_unchecked(xcbConn, geomReply->root);
+    QScopedPointer<xcb_get_geometry_reply_t,QScopedPointerPodDeleter>
+            geomRootReply(xcb_get_geometry_reply(xcbConn, geomRootCookie, nullptr));
+
+    if (geomRootReply.isNull())
+        return QPixmap::fromImage(nativeImage);
+
+    xcb_translate_coordinates_cookie_t translateCookie = xcb_translate_coordinates_unchecked(
+                                                             xcbConn, window, geomReply->root, geomRootReply->x, geomRootReply->y);
+    QScopedPointer<xcb_translate_coordinates_reply_t,QScopedPointerPodDeleter>
+            translateReply(xcb_translate_coordinates_reply(xcbConn, translateCookie, nullptr));
+
+    if (translateReply)
+        blendCursorImage(nativeImage, translateReply->dst_x, translateReply->dst_y);
+
+    return QPixmap::fromImage(nativeImage);
+}
+
+QPixmap ZXCBTools::grabCurrent(bool includeDecorations, bool includePointer, QRect *windowRegion)
+{
+    return getWindowPixmap(currentWindow(includeDecorations, windowRegion), includePointer);
+}
+
+// Returns the window under the cursor, its root-relative geometry goes to windowRegion
+xcb_window_t ZXCBTools::currentWindow(bool includeDecorations, QRect *windowRegion)
+{
+    xcb_connection_t* c = connection(ZXCBTools::instance());
+
+
+    xcb_window_t child = windowUnderCursor(includeDecorations);
+
+    const QRect cachedGeom = windowTree()->rootGeometry(child);
+    if (!cachedGeom.isNull()) {
+        *windowRegion = cachedGeom;
+        return child;
+    }
+
+    xcb_query_tree_cookie_t tc = xcb_query_tree_unchecked(c, child);
+    QScopedPointer<xcb_query_tree_reply_t,QScopedPointerPodDeleter> tree(xcb_query_tree_reply(c, tc, nullptr));
+
+    QRect geom = getWindowGeometry(child);
+    if (!geom.isNull()) {
+        if (tree) {
+            xcb_translate_coordinates_cookie_t tc = xcb_translate_coordinates(
+                                                        c, tree->parent, appRootWindow(),
+                                                        geom.x(), geom.y());
+            QScopedPointer<xcb_translate_coordinates_reply_t,QScopedPointerPodDeleter> tr
+                    (xcb_translate_coordinates_reply(c, tc, nullptr));
+
+            if (tr) {
+                geom.setX(tr->dst_x);
+                geom.setY(tr->dst_y);
+            }
+        }
+        *windowRegion = geom;
+    }
+
+    return child;
+}
+
+// Paints the pointer over the image, which covers the root area at x, y.
+// An image not shared with any other QImage, like a fresh frame buffer view,
+// is painted in place. A shared one is detached first, so the other copies
+// never see the pointer.
+void ZXCBTools::blendCursorImage(QImage &image, int x, int y)
+{
+    // first we get the cursor position, compute the co-ordinates of the region
+    // of the screen we're grabbing, and see if the cursor is actually visible in
+    // the region
+
+    QPoint cursorPos = QCursor::pos();
+    QRect screenRect(x, y, image.width(), image.height());
+
+    if (!(screenRect.contains(cursorPos)))
+        return;
+
+    // the cursor image is cached until the server reports a cursor change
+
+    QImage cursorImage;
+    QPoint hotspot;
+    if (!cursorCache()->cursorImage(&cursorImage, &hotspot))
+        return;
+
+    // a small fix for the cursor position for fancier cursors
+    // and translation to our screen rectangle
+
+    cursorPos -= hotspot + QPoint(x, y);
+
+    if (!image.isDetached())
+        image.detach();
+
+    QPainter painter(&image);
+    painter.drawImage(cursorPos, cursorImage);
+}
+
+// Iterates over the window w and its children, thereby building a tree of
+// window descriptors. Windows in non-viewable state or with height or width
+// smaller than minSize will be ignored.
+// The live window tree answers without any round trip, the server is queried
+// only for windows the tree doesn't know (yet).
+void ZXCBTools::getWindowsRecursive( QVector<QRect> &windows, xcb_window_t w, int rx, int ry, int depth )
+{
+    if (!windowTree()->collectWindows(windows, w, rx, ry, depth, minSize)) {
+        queryWindowsRecursive(windows, w, rx, ry, depth);
+        return;
+    }
+
+    if ( depth == 0 ) {
+        std::sort(windows.begin(), windows.end(), []( const QRect& r1, const QRect& r2 )
+        {
+            return r1.width() * r1.height() < r2.width() * r2.height();
+        });
+    }
+}
+
+// Same as getWindowsRecursive, always asking the server.
+// The tree is walked breadth-first: all requests for one level are sent
+// before the first reply is awaited, so each level costs a single round trip.
+void ZXCBTools::queryWindowsRecursive( QVector<QRect> &windows, xcb_window_t w, int rx, int ry, int depth )
+{
+    struct ZWindowNode {
+        xcb_window_t window;
+        int rx;
+        int ry;
+        int depth;
+    };
+
+    xcb_connection_t* c = connection(ZXCBTools::instance());
+
+    QVector<ZWindowNode> level( { { w, rx, ry, depth } } );
+    QVector<ZWindowNode> viewable;
+    QVector<xcb_get_window_attributes_cookie_t> attsCookies;
+    QVector<xcb_get_geometry_cookie_t> geomCookies;
+    QVector<xcb_query_tree_cookie_t> treeCookies;
+
+    while (!level.isEmpty()) {
+        attsCookies.clear();
+        geomCookies.clear();
+        for (const auto &node : qAsConst(level)) {
+            attsCookies.append(xcb_get_window_attributes_unchecked(c, node.window));
+            geomCookies.append(xcb_get_geometry_unchecked(c, node.window));
+        }
+
+        viewable.clear();
+        treeCookies.clear();
+        for (int i=0;i<level.count();i++) {
+            const ZWindowNode &node = level.at(i);
+
+            QScopedPointer<xcb_get_window_attributes_reply_t,QScopedPointerPodDeleter>
+                    atts(xcb_get_window_attributes_reply(c, attsCookies.at(i), nullptr));
+            QScopedPointer<xcb_get_geometry_reply_t,QScopedPointerPodDeleter>
+                    geom(xcb_get_geometry_reply(c, geomCookies.at(i), nullptr));
+
+            if ( atts && geom &&
+                 atts->map_state == XCB_MAP_STATE_VIEWABLE &&
+                 geom->width >= minSize && geom->height >= minSize ) {
+                int x = 0;
+                int y = 0;
+                if ( node.depth != 0 ) {
+                    x = geom->x + node.rx;
+                    y = geom->y + node.ry;
+                }
+
+                QRect r( x, y, geom->width, geom->height );
+                if (!windows.contains(r))
+                    windows.append(r);
+
+                viewable.append(ZWindowNode { node.window, x, y, node.depth });
+                treeCookies.append(xcb_query_tree_unchecked(c, node.window));
+            }
+        }
+
+        level.clear();
+        for (int i=0;i<viewable.count();i++) {
+            const ZWindowNode &node = viewable.at(i);
+
+            QScopedPointer<xcb_query_tree_reply_t,QScopedPointerPodDeleter>
+                    tree(xcb_query_tree_reply(c, treeCookies.at(i), nullptr));
+
+            if (tree) {
+                xcb_window_t* child = xcb_query_tree_children(tree.data());
+                for (unsigned int j=0;j<tree->children_len;j++)
+                    level.append(ZWindowNode { child[j], node.rx, node.ry, node.depth + 1 }); // NOLINT
+            }
+        }
+    }
+
+    if ( depth == 0 ) {
+        std::sort(windows.begin(), windows.end(), []( const QRect& r1, const QRect& r2 )
+        {
+            return r1.width() * r1.height() < r2.width() * r2.height();
+        });
+    }
+}
+
+// Looks for the client window with WM_STATE property set in the subtree of w,
+// level by level, so the nearest client is returned.
+xcb_window_t ZXCBTools::findRealWindow( xcb_window_t w, int depth )
+{
+    const int maxDepth = 5;
+
+    auto* inst = ZXCBTools::instance();
+    xcb_connection_t* c = connection(inst);
+
+    if (inst->m_wmStateAtom == XCB_NONE) {
+        qWarning() << "Unable to allocate xcb atom";
+        return 0;
+    }
+
+    xcb_window_t client = XCB_NONE;
+    if (windowTree()->findClient(w, maxDepth - depth, &client))
+        return client;
+
+    QVector<xcb_window_t> level( { w } );
+    QVector<xcb_get_property_cookie_t> propCookies;
+    QVector<xcb_query_tree_cookie_t> treeCookies;
+
+    for (int d = depth; (d <= maxDepth) && !level.isEmpty(); d++) {
+        propCookies.clear();
+        for (const auto &window : qAsConst(level))
+            propCookies.append(xcb_get_property(c, 0, window, inst->m_wmStateAtom, XCB_GET_PROPERTY_TYPE_ANY, 0, 0 ));
+
+        xcb_window_t ret = XCB_NONE;
+        for (int i=0;i<level.count();i++) {
+            QScopedPointer<xcb_get_property_reply_t,QScopedPointerPodDeleter>
+                    pr(xcb_get_property_reply(c, propCookies.at(i), nullptr));
+
+            if ((ret == XCB_NONE) && pr && pr->type != XCB_NONE)
+                ret = level.at(i);
+        }
+        if ((ret != XCB_NONE) || (d == maxDepth))
+            return ret;
+
+        treeCookies.clear();
+        for (const auto &window : qAsConst(level))
+            treeCookies.append(xcb_query_tree_unchecked(c, window));
+
+        level.clear();
+        for (const auto &cookie : qAsConst(treeCookies)) {
+            QScopedPointer<xcb_query_tree_reply_t,QScopedPointerPodDeleter>
+                    tree(xcb_query_tree_reply(c, cookie, nullptr));
+
+            if (tree) {
+                xcb_window_t* child = xcb_query_tree_children(tree.data());
+                for (unsigned int i=0;i<tree->children_len;i++)
+                    level.append(child[i]); // NOLINT
+            }
+        }
+    }
+
+    return XCB_NONE;
+}
+
+xcb_window_t ZXCBTools::windowUnderCursor( bool includeDecorations )
+{
+    xcb_connection_t* c = connection(ZXCBTools::instance());
+
+    xcb_window_t child = appRootWindow();
+
+    xcb_query_pointer_cookie_t pc = xcb_query_pointer(c,appRootWindow());
+    QScopedPointer<xcb_query_pointer_reply_t,QScopedPointerPodDeleter>
+            pr(xcb_query_pointer_reply(c, pc, nullptr));
+
+    if (pr && pr->child!=XCB_NONE )
+        child = pr->child;
+
+    if( !includeDecorations ) {
+        xcb_window_t real_child = findRealWindow( child );
+
+        if( real_child != XCB_NONE ) { // test just in case
+            child = real_child;
+        }
+    }
+
+    return child;
+}
+
+bool ZXCBTools::ungrabKey(xcb_keycode_t keycode, uint16_t modifiers, xcb_window_t window)
+{
+    xcb_connection_t* c = connection(ZXCBTools::instance());
+    if (c==nullptr) return false;
+
+    xcb_void_cookie_t vc = xcb_ungrab_key(c, keycode, window, modifiers);
+
+    return (xcb_request_check(c, vc)==nullptr);
+}
+
+bool ZXCBTools::grabKey(xcb_keycode_t keycode, uint16_t modifiers, xcb_window_t window)
+{
+    xcb_connection_t* c = connection(ZXCBTools::instance());
+    if (c==nullptr) return false;
+
+    xcb_void_cookie_t vc = xcb_grab_key(c, 1, window, modifiers, keycode,
+                                        XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+
+    if (xcb_request_check(c, vc)) {
+        ungrabKey(keycode, modifiers, window);
+        return false;
+    }
+
+    return true;
+}
+
+xcb_keysym_t ZXCBTools::keyToKeysym(const Qt::Key key, const Qt::KeyboardModifiers mods)
+{
+    unsigned int code = 0;
+    switch( key )
+    {
+        // modifiers are handled separately
+        case Qt::Key_Shift: code = XK_Shift_L; break;
+        case Qt::Key_Control: code = XK_Control_L; break;
+        case Qt::Key_Meta: code = XK_Meta_L; break;
+        case Qt::Key_Alt: code = XK_Alt_L; break;
+        case Qt::Key_Escape: code = XK_Escape; break;
+        case Qt::Key_Tab:
+        case Qt::Key_Backtab:
+            code = XK_Tab;
+            break;
+        case Qt::Key_Backspace: code = XK_BackSpace; break;
+        case Qt::Key_Return: code = XK_Return; break;
+        case Qt::Key_Insert: code = XK_Insert; break;
+        case Qt::Key_Delete: code = XK_Delete; break;
+        case Qt::Key_Pause: code = XK_Pause; break;
+        case Qt::Key_Print: code = XK_Print; break;
+        case Qt::Key_Home: code = XK_Home; break;
+        case Qt::Key_End: code = XK_End; break;
+        case Qt::Key_Left: code = XK_Left; break;
+        case Qt::Key_Up: code = XK_Up; break;
+        case Qt::Key_Right: code = XK_Right; break;
+        case Qt::Key_Down: code = XK_Down; break;
+        case Qt::Key_PageUp: code = XK_Prior; break;
+        case Qt::Key_PageDown: code = XK_Next; break;
+        case Qt::Key_CapsLock: code = XK_Caps_Lock; break;
+        case Qt::Key_NumLock: code = XK_Num_Lock; break;
+        case Qt::Key_ScrollLock: code = XK_Scroll_Lock; break;
+        case Qt::Key_Super_L: code = XK_Super_L; break;
+        case Qt::Key_Super_R: code = XK_Super_R; break;
+        case Qt::Key_Menu: code = XK_Menu; break;
+        case Qt::Key_Hyper_L: code = XK_Hyper_L; break;
+        case Qt::Key_Hyper_R: code = XK_Hyper_R; break;
+        case Qt::Key_Help: code = XK_Help; break;
+        case Qt::Key_AltGr: code = XK_ISO_Level3_Shift; break;
+        case Qt::Key_Multi_key: code = XK_Multi_key; break;
+        case Qt::Key_SingleCandidate: code = XK_SingleCandidate; break;
+        case Qt::Key_MultipleCandidate: code = XK_MultipleCandidate; break;
+        case Qt::Key_PreviousCandidate: code = XK_PreviousCandidate; break;
+        case Qt::Key_Mode_switch: code = XK_Mode_switch; break;
+        default: break;
+    }
+
+    if( key >= Qt::Key_F1 && key <= Qt::Key_F35 )
+    {
+        code = XK_F1 + key - Qt::Key_F1;
+    }
+
+    if ( code == 0 ) {
+        QKeySequence seq(key);
+        if (((mods & Qt::ControlModifier) != 0U) && seq.toString().length() == 1) {
+            QString s = seq.toString();
+            if ((mods & Qt::ShiftModifier) == 0U)
+                s = s.toLower();
+
+            code = s.front().unicode();
+        } else if (seq.toString().length() == 1){
+            code = seq.toString().front().unicode();
+        }
+    }
+
+    return code;
+}
+
+xcb_keycode_t ZXCBTools::nativeKeycode(Qt::Key key, Qt::KeyboardModifiers modifiers)
+{
+    if (key==0) return 0;
+
+    if (connection(ZXCBTools::instance())==nullptr) return 0;
+
+    return keySymbols()->keycode(keyToKeysym(key, modifiers));
+}
+
+uint16_t ZXCBTools::nativeModifiers(Qt::KeyboardModifiers modifiers)
+{
+    // ShiftMask, LockMask, ControlMask, Mod1Mask, Mod2Mask, Mod3Mask, Mod4Mask, and Mod5Mask
+    uint16_t native = 0;
+    if ((modifiers & Qt::ShiftModifier) != 0U)
+        native |= XCB_MOD_MASK_SHIFT;
+    if ((modifiers & Qt::ControlModifier) != 0U)
+        native |= XCB_MOD_MASK_CONTROL;
+    if ((modifiers & Qt::AltModifier) != 0U)
+        native |= XCB_MOD_MASK_1;
+    if ((modifiers & Qt::MetaModifier) != 0U)
+        native |= XCB_MOD_MASK_4;
+
+    return native;
+}
+
+bool ZXCBTools::registerShortcut(xcb_keycode_t nativeKey, uint16_t nativeMods)
+{
+    return grabKey(nativeKey, nativeMods, static_cast<unsigned int>(appRootWindow()));
+}
+
+bool ZXCBTools::unregisterShortcut(xcb_keycode_t nativeKey, uint16_t nativeMods)
+{
+    return ungrabKey(nativeKey, nativeMods, static_cast<unsigned int>(appRootWindow()));
+}
@@ -0,0 +1,135 @@
+#ifndef XCBTOOLS_H
+#define XCBTOOLS_H
+
+#include <QObject>
+#include <QPixmap>
+#include <QVector>
+#include <QRect>
+#include <QThread>
+#include <QMutex>
+#include <QAtomicPointer>
+#include <QAtomicInt>
+#include <QHash>
+#include <QPointer>
+#include <QScopedPointer>
+
+#include <functional>
+
+#include <xcb/xcb.h>
+#include <xcb/xcb_image.h>
+#include <xcb/xcb_keysyms.h>
+#include <xcb/xfixes.h>
+#include <xcb/damage.h>
+
+class ZAbstractXCBEventListener;
+class ZCaptureWorker;
+class ZWindowTree;
+class ZCursorCache;
+class ZKeySymbolsCache;
+
+// Receives an asynchronously grabbed image, null on failure
+using ZImageCallback = std::function<void(QImage image)>;
+
+class ZXCBTools : public QObject
+{
+    Q_OBJECT
+private:
+    using ZListenerList = QVector<ZAbstractXCBEventListener *>;
+    using ZListenerTable = QVector<ZListenerList>;
+
+    QMutex m_listenersMutex; // serializes writers, dispatch does not lock
+    QPointer<QThread> m_eventLoopThread;
+    QMultiHash<ZAbstractXCBEventListener *, quint8> m_eventListeners;
+    QAtomicPointer<const ZListenerTable> m_listenerTable;
+    QAtomicInt m_dispatchSequence;
+    QVector<const ZListenerTable *> m_retiredTables; // event loop thread only
+    xcb_connection_t* m_connection { nullptr };
+    xcb_atom_t m_closeAtom { 0 };
+    xcb_atom_t m_wmStateAtom { 0 };
+    quint8 m_damageEventBase { 0 };
+    quint8 m_xfixesEventBase { 0 };
+
+    QPointer<QThread> m_captureThread;
+    QPointer<ZCaptureWorker> m_captureWorker;
+
+    QMutex m_cachesMutex;
+    QPointer<ZWindowTree> m_windowTree;
+    QPointer<ZCursorCache> m_cursorCache;
+    QPointer<ZKeySymbolsCache> m_keySymbols;
+
+    QThread *createEventLoop();
+    const ZListenerTable *publishListeners();
+    void retireListeners(const ZListenerTable *table);
+    void exitEventLoop();
+    void startCaptureThread();
+    void stopCaptureThread();
+    template<typename Func>
+    static QImage runCapture(Func grab);
+    template<typename Func>
+    static void queueCapture(Func grab, QObject *context, const ZImageCallback &callback);
+    template<typename T, typename Func>
+    static T* sharedCache(QPointer<T> &cache, Func create);
+    void initDamage();
+    void initXFixes();
+    static ZCursorCache* cursorCache();
+    static bool ungrabKey(xcb_keycode_t keycode, uint16_t modifiers, xcb_window_t window);
+    static bool grabKey(xcb_keycode_t keycode, uint16_t modifiers, xcb_window_t window);
+public:
+    explicit ZXCBTools(QObject *parent = nullptr);
+    ~ZXCBTools() override;
+
+    static ZXCBTools* instance();
+    static xcb_connection_t* connection(ZXCBTools *inst);
+    static void addEventListener(ZAbstractXCBEventListener *receiver, quint8 responseType);
+    static void removeEventListener(ZAbstractXCBEventListener *receiver);
+    static quint8 damageEventBase();
+    static ZWindowTree* windowTree();
+    static ZKeySymbolsCache* keySymbols();
+
+    static xcb_window_t appRootWindow();
+    static QRect getWindowGeometry(xcb_window_t window);
+    static QImage getWindowImage(xcb_window_t window);
+    static QImage getRootImage(const QRect &rect);
+    static void requestWindowImage(xcb_window_t window, QObject *context,
+                                   const ZImageCallback &callback);
+    static void requestRootImage(const QRect &rect, QObject *context,
+                                 const ZImageCallback &callback);
+    static QPixmap getRootPixmap(const QRect &rect, bool blendPointer);
+    static QPixmap rootImageToPixmap(QImage image, const QRect &rect, bool blendPointer);
+    static QPixmap getWindowPixmap(xcb_window_t window, bool blendPointer);
+    static QPixmap windowImageToPixmap(QImage image, xcb_window_t window, bool blendPointer);
+    static QPixmap grabCurrent(bool includeDecorations, bool includePointer, QRect *windowRegion);
+    static xcb_window_t currentWindow(bool includeDecorations, QRect *windowRegion);
+    static void blendCursorImage(QImage &image, int x, int y);
+    static void getWindowsRecursive( QVector<QRect> &windows, xcb_window_t w, int rx = 0, int ry = 0, int depth = 0 );
+    static void queryWindowsRecursive( QVector<QRect> &windows, xcb_window_t w, int rx = 0, int ry = 0, int depth = 0 );
+    static xcb_window_t findRealWindow( xcb_window_t w, int depth = 0 );
+    static xcb_window_t windowUnderCursor( bool includeDecorations = true );
+
+    static xcb_keycode_t nativeKeycode(Qt::Key key, Qt::KeyboardModifiers modifiers);
+    static uint16_t nativeModifiers(Qt::KeyboardModifiers modifiers);
+    static bool registerShortcut(xcb_keycode_t nativeKey, uint16_t nativeMods);
+    static bool unregisterShortcut(xcb_keycode_t nativeKey, uint16_t nativeMods);
+    static xcb_keysym_t keyToKeysym(const Qt::Key key, const Qt::KeyboardModifiers mods);
+};
+
+class ZAbstractXCBEventListener : public QObject
+{
+    Q_OBJECT
+
+    friend class ZXCBTools;
+
+public:
+    explicit ZAbstractXCBEventListener(QObject* parent = nullptr) : QObject(parent) {}
+    ~ZAbstractXCBEventListener() override {}
+
+protected:
+    // Called on the event loop thread. Handlers may use the caches and add or
+    // remove listeners, but must not wait for any thread that may be inside
+    // removeEventListener (which waits for the dispatch in progress), e.g. with
+    // a blocking queued call or a mutex held around the removal.
+    virtual void nativeEventHandler(const xcb_generic_event_t* event) = 0;
+};
+
+#endif // XCBTOOLS_H
+
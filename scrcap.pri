@@ -0,0 +1,42 @@
+QT       += core gui
+
+CONFIG += link_pkgconfig c++17 rtti
+
+PKGCONFIG += xcb xcb-xfixes xcb-image xcb-keysyms xcb-shm xcb-damage zlib
+
+INCLUDEPATH += $$PWD/core
+DEPENDPATH += $$PWD/core
+
+packagesExist(gstreamer-1.0) {
+    PKGCONFIG += gstreamer-1.0
+    CONFIG += use_gst
+    DEFINES += WITH_GST=1
+    message("GStreamer support: YES")
+}
+
+!use_gst {
+    message("GStreamer support: NO")
+}
+
+# video recording feeds the pipeline through appsrc
+use_gst:packagesExist(gstreamer-app-1.0) {
+    PKGCONFIG += gstreamer-app-1.0
+    CONFIG += use_gst_app
+    DEFINES += WITH_GST_APP=1
+    message("GStreamer video recording: YES")
+}
+
+!use_gst_app {
+    message("GStreamer video recording: NO")
+}
+
+packagesExist(libwebpmux) {
+    PKGCONFIG += libwebp libwebpmux
+    CONFIG += use_webp
+    DEFINES += WITH_WEBP=1
+    message("Animated WebP support: YES")
+}
+
+!use_webp {
+    message("Animated WebP support: NO")
+}
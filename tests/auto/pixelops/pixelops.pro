@@ -0,0 +1,7 @@
+include(../../tests.pri)
+
+TARGET = tst_pixelops
+CONFIG += testcase
+
+SOURCES += \
+    tst_pixelops.cpp
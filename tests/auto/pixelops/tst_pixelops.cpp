@@ -0,0 +1,164 @@
+#include <QtTest>
+#include <QRandomGenerator>
+#include <QVector>
+
+#include <cstring>
+
+#include "pixelops.h"
+#include "coredefs.h"
+
+Q_DECLARE_METATYPE(ZPixelOps::ZInstructionSet)
+
+// Checks the vectorized kernels byte for byte against the scalar reference.
+// Rows of every width up to maxWidth cover all tail lengths of both the
+// 4-pixel SSE2 and the 8-pixel AVX2 loops, odd strides misalign the rows.
+class TestPixelOps : public QObject
+{
+    Q_OBJECT
+
+private:
+    static const int maxWidth = 96;
+    static const int rowCount = 3;
+
+    static QVector<quint32> randomPixels(int count, quint32 seed);
+    static void skipUnsupported(ZPixelOps::ZInstructionSet isa);
+
+private Q_SLOTS:
+    void convertDepth30_data();
+    void convertDepth30();
+    void convertDepth30Patterns_data();
+    void convertDepth30Patterns();
+    void countChangedPixels_data();
+    void countChangedPixels();
+};
+
+QVector<quint32> TestPixelOps::randomPixels(int count, quint32 seed)
+{
+    QRandomGenerator generator(seed);
+    QVector<quint32> res(count);
+    for (auto &pixel : res)
+        pixel = generator.generate();
+    return res;
+}
+
+void TestPixelOps::skipUnsupported(ZPixelOps::ZInstructionSet isa)
+{
+    if (isa > ZPixelOps::bestInstructionSet())
+        QSKIP("Instruction set is not supported by this CPU");
+}
+
+void TestPixelOps::convertDepth30_data()
+{
+    QTest::addColumn<ZPixelOps::ZInstructionSet>("isa");
+    QTest::addColumn<int>("padding");
+
+    const QVector<int> paddings({ 0, 1, 3, 7 });
+    for (const int padding : paddings) {
+        QTest::newRow(QByteArray("sse2 padding " + QByteArray::number(padding)).constData())
+                << ZPixelOps::SSE2 << padding;
+        QTest::newRow(QByteArray("avx2 padding " + QByteArray::number(padding)).constData())
+                << ZPixelOps::AVX2 << padding;
+    }
+}
+
+void TestPixelOps::convertDepth30()
+{
+    QFETCH(ZPixelOps::ZInstructionSet, isa);
+    QFETCH(int, padding);
+
+    skipUnsupported(isa);
+
+    for (int width = 0; width <= maxWidth; width++) {
+        const int stride = width + padding;
+        const QVector<quint32> source = randomPixels(stride * rowCount + 1, static_cast<quint32>(width));
+
+        // start one pixel in, so even strides are not 16 byte aligned either
+        QVector<quint32> expected = source;
+        QVector<quint32> actual = source;
+        for (int row = 0; row < rowCount; row++) {
+            const int offset = 1 + row * stride;
+            ZPixelOps::convertDepth30Scalar(expected.data() + offset, static_cast<quint32>(width));
+            ZPixelOps::convertDepth30(actual.data() + offset, static_cast<quint32>(width), isa);
+        }
+
+        // padding and the leading pixel must stay untouched as well
+        QVERIFY2(memcmp(expected.constData(), actual.constData(),
+                        static_cast<size_t>(expected.size()) * sizeof(quint32)) == 0,
+                 qPrintable(QSL("width %1, stride %2").arg(width).arg(stride)));
+    }
+}
+
+void TestPixelOps::convertDepth30Patterns_data()
+{
+    QTest::addColumn<ZPixelOps::ZInstructionSet>("isa");
+
+    QTest::newRow("sse2") << ZPixelOps::SSE2;
+    QTest::newRow("avx2") << ZPixelOps::AVX2;
+}
+
+// Every channel value in every lane, with the unused top bits set and clear
+void TestPixelOps::convertDepth30Patterns()
+{
+    QFETCH(ZPixelOps::ZInstructionSet, isa);
+
+    skipUnsupported(isa);
+
+    const quint32 channelValues = 1024;
+    const quint32 topBits = 0xc0000000U;
+
+    QVector<quint32> source;
+    for (quint32 value = 0; value < channelValues; value++) {
+        source.append((value << 20) | (value << 10) | value); // NOLINT
+        source.append(topBits | (value << 20)); // NOLINT
+        source.append(topBits | (value << 10)); // NOLINT
+        source.append(topBits | value);
+    }
+
+    QVector<quint32> expected = source;
+    QVector<quint32> actual = source;
+    ZPixelOps::convertDepth30Scalar(expected.data(), static_cast<quint32>(expected.size()));
+    ZPixelOps::convertDepth30(actual.data(), static_cast<quint32>(actual.size()), isa);
+
+    QCOMPARE(actual, expected);
+}
+
+void TestPixelOps::countChangedPixels_data()
+{
+    convertDepth30_data();
+}
+
+void TestPixelOps::countChangedPixels()
+{
+    QFETCH(ZPixelOps::ZInstructionSet, isa);
+    QFETCH(int, padding);
+
+    skipUnsupported(isa);
+
+    QRandomGenerator generator(1);
+    for (int width = 0; width <= maxWidth; width++) {
+        const int stride = width + padding;
+        const QVector<quint32> a = randomPixels(stride * rowCount + 1, static_cast<quint32>(width));
+
+        // about every third pixel differs, in any of its bits
+        QVector<quint32> b = a;
+        for (auto &pixel : b) {
+            if (generator.bounded(3) == 0)
+                pixel ^= 1U << generator.bounded(32);
+        }
+
+        for (int row = 0; row < rowCount; row++) {
+            const int offset = 1 + row * stride;
+            const quint32 expected = ZPixelOps::countChangedPixelsScalar(a.constData() + offset, b.constData() + offset,
+                                                                         static_cast<quint32>(width));
+            const quint32 actual = ZPixelOps::countChangedPixels(a.constData() + offset, b.constData() + offset,
+                                                                 static_cast<quint32>(width), isa);
+            QVERIFY2(actual == expected,
+                     qPrintable(QSL("width %1, stride %2, row %3: %4 != %5")
+                                .arg(width).arg(stride).arg(row).arg(actual).arg(expected)));
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestPixelOps)
+
+#include "tst_pixelops.moc"
@@ -0,0 +1,196 @@
+#include <QtTest>
+#include <QAtomicInt>
+#include <QScopedPointer>
+#include <QThread>
+#include <QVector>
+
+#include <xcb/xcb.h>
+
+#include <cstring>
+
+#include "xcbtools.h"
+
+namespace {
+const int clientMessageCount = 20000;
+const int flushInterval = 64;
+const int writerThreadCount = 4;
+const int dispatchTimeout = 30000;
+const char testAtomName[] = "_ZXCB_DISPATCH_TEST";
+}
+
+// Counts the test client messages. A call after removeEventListener has
+// returned is counted as a violation.
+class ZCountingListener : public ZAbstractXCBEventListener
+{
+    Q_OBJECT
+
+private:
+    xcb_atom_t m_atom;
+
+public:
+    QAtomicInt calls;
+    QAtomicInt removed;
+    QAtomicInt callsAfterRemoval;
+
+    explicit ZCountingListener(xcb_atom_t atom) : m_atom(atom) {}
+
+protected:
+    void nativeEventHandler(const xcb_generic_event_t* event) override
+    {
+        const auto *clientMessage = reinterpret_cast<const xcb_client_message_event_t *>(event);
+        if (clientMessage->type != m_atom) return;
+
+        calls.ref();
+        if (removed.loadAcquire() != 0)
+            callsAfterRemoval.ref();
+    }
+};
+
+// Adds and removes a nested listener from inside the dispatch and uses the
+// caches, which used to deadlock against writers on other threads. The nested
+// listener must not be called by the dispatch that removed it either.
+class ZReentrantListener : public ZAbstractXCBEventListener
+{
+    Q_OBJECT
+
+private:
+    xcb_atom_t m_atom;
+    ZCountingListener m_nested;
+
+public:
+    explicit ZReentrantListener(xcb_atom_t atom) : m_atom(atom), m_nested(atom) {}
+    ~ZReentrantListener() override { ZXCBTools::removeEventListener(&m_nested); }
+
+    int violations() const { return m_nested.callsAfterRemoval.loadAcquire(); }
+
+protected:
+    void nativeEventHandler(const xcb_generic_event_t* event) override
+    {
+        const auto *clientMessage = reinterpret_cast<const xcb_client_message_event_t *>(event);
+        if (clientMessage->type != m_atom) return;
+
+        if ((clientMessage->data.data32[0] % 2) == 0) {
+            m_nested.removed.storeRelease(0);
+            ZXCBTools::addEventListener(&m_nested, XCB_CLIENT_MESSAGE);
+        } else {
+            ZXCBTools::removeEventListener(&m_nested);
+            m_nested.removed.storeRelease(1);
+        }
+        ZXCBTools::windowTree();
+    }
+};
+
+// Floods the ZXCBTools event loop with client messages while several threads
+// add and remove listeners. Every message must reach the permanent listener,
+// and a removed listener must never be called again.
+class TestXCBDispatch : public QObject
+{
+    Q_OBJECT
+
+private:
+    xcb_connection_t* m_connection { nullptr };
+    xcb_atom_t m_atom { XCB_ATOM_NONE };
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void addRemoveDuringDispatch();
+};
+
+void TestXCBDispatch::initTestCase()
+{
+    if (qEnvironmentVariableIsEmpty("DISPLAY"))
+        QSKIP("No X server available");
+
+    m_connection = xcb_connect(nullptr, nullptr);
+    if (xcb_connection_has_error(m_connection) != 0)
+        QSKIP("No X server available");
+
+    xcb_intern_atom_cookie_t ac = xcb_intern_atom(m_connection, 0, strlen(testAtomName), testAtomName);
+    QScopedPointer<xcb_intern_atom_reply_t, QScopedPointerPodDeleter> acr(xcb_intern_atom_reply(m_connection, ac, nullptr));
+    QVERIFY(!acr.isNull());
+    m_atom = acr->atom;
+}
+
+void TestXCBDispatch::cleanupTestCase()
+{
+    if (m_connection)
+        xcb_disconnect(m_connection);
+}
+
+void TestXCBDispatch::addRemoveDuringDispatch()
+{
+    auto* inst = ZXCBTools::instance();
+    xcb_connection_t* toolsConnection = ZXCBTools::connection(inst);
+    QVERIFY(xcb_connection_has_error(toolsConnection) == 0);
+
+    // messages sent with an empty event mask go to the client that created
+    // the window, i.e. to the ZXCBTools event loop
+    const xcb_setup_t* setup = xcb_get_setup(toolsConnection);
+    xcb_screen_t* screen = xcb_setup_roots_iterator(setup).data;
+    const xcb_window_t window = xcb_generate_id(toolsConnection);
+    xcb_create_window(toolsConnection, XCB_COPY_FROM_PARENT, window, screen->root,
+                      0, 0, 1, 1, 0, XCB_WINDOW_CLASS_INPUT_ONLY,
+                      screen->root_visual, 0, nullptr);
+    xcb_flush(toolsConnection);
+
+    ZCountingListener sentinel(m_atom);
+    ZReentrantListener reentrant(m_atom);
+    ZXCBTools::addEventListener(&sentinel, XCB_CLIENT_MESSAGE);
+    ZXCBTools::addEventListener(&reentrant, XCB_CLIENT_MESSAGE);
+
+    QAtomicInt flooding(1);
+    QAtomicInt violations;
+    QAtomicInt cycles;
+    QVector<QThread*> writers;
+    for (int i = 0; i < writerThreadCount; i++) {
+        writers.append(QThread::create([this,&flooding,&violations,&cycles](){
+            while (flooding.loadAcquire() != 0) {
+                auto *listener = new ZCountingListener(m_atom);
+                ZXCBTools::addEventListener(listener, XCB_CLIENT_MESSAGE);
+                QThread::yieldCurrentThread();
+                ZXCBTools::removeEventListener(listener);
+                listener->removed.storeRelease(1);
+                QThread::yieldCurrentThread();
+                violations.fetchAndAddOrdered(listener->callsAfterRemoval.loadAcquire());
+                delete listener;
+                cycles.ref();
+            }
+        }));
+        writers.last()->start();
+    }
+
+    xcb_client_message_event_t event {};
+    event.response_type = XCB_CLIENT_MESSAGE;
+    event.format = 32; // NOLINT
+    event.window = window;
+    event.type = m_atom;
+    for (int i = 0; i < clientMessageCount; i++) {
+        event.data.data32[0] = static_cast<quint32>(i);
+        xcb_send_event(m_connection, 0, window, XCB_EVENT_MASK_NO_EVENT, reinterpret_cast<const char *>(&event));
+        if ((i % flushInterval) == 0)
+            xcb_flush(m_connection);
+    }
+    xcb_flush(m_connection);
+
+    QTRY_COMPARE_WITH_TIMEOUT(sentinel.calls.loadAcquire(), clientMessageCount, dispatchTimeout);
+
+    flooding.storeRelease(0);
+    for (auto *writer : qAsConst(writers)) {
+        writer->wait();
+        delete writer;
+    }
+
+    ZXCBTools::removeEventListener(&reentrant);
+    ZXCBTools::removeEventListener(&sentinel);
+    xcb_destroy_window(toolsConnection, window);
+    xcb_flush(toolsConnection);
+
+    QVERIFY(cycles.loadAcquire() > 0);
+    QCOMPARE(violations.loadAcquire(), 0);
+    QCOMPARE(reentrant.violations(), 0);
+}
+
+QTEST_GUILESS_MAIN(TestXCBDispatch)
+
+#include "tst_xcbdispatch.moc"
@@ -0,0 +1,7 @@
+include(../../tests.pri)
+
+TARGET = tst_xcbdispatch
+CONFIG += testcase
+
+SOURCES += \
+    tst_xcbdispatch.cpp
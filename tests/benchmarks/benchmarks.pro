@@ -0,0 +1,9 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    shmcapture \
+    pixelops \
+    changedetector \
+    windowtree \
+    windowindex \
+    pngwriter
@@ -0,0 +1,108 @@
+#include <QtTest>
+#include <QImage>
+
+#include "changedetector.h"
+
+// Tile hashes of ZChangeDetector against the full QImage compare the autocapture
+// used before, which kept a whole copy of the previous frame. Frames are separate
+// deep copies, as consecutive grabs are. The change is a small square near the
+// bottom right corner, so the plain compare can't stop early.
+class BenchChangeDetector : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QImage testFrame(const QSize &size, bool changed);
+    static void addFrameRows();
+
+private Q_SLOTS:
+    void qimageCompare();
+    void qimageCompare_data();
+    void tileHashes();
+    void tileHashes_data();
+};
+
+QImage BenchChangeDetector::testFrame(const QSize &size, bool changed)
+{
+    const int squareSize = 16;
+
+    QImage res(size, QImage::Format_RGB32);
+    for (int y = 0; y < size.height(); y++) {
+        auto *line = reinterpret_cast<QRgb *>(res.scanLine(y));
+        for (int x = 0; x < size.width(); x++)
+            line[x] = qRgb(x & 0xff, y & 0xff, (x + y) & 0xff); // NOLINT
+    }
+
+    if (changed) {
+        const QRect square(size.width() - squareSize * 2, size.height() - squareSize * 2,
+                           squareSize, squareSize);
+        for (int y = square.top(); y <= square.bottom(); y++) {
+            auto *line = reinterpret_cast<QRgb *>(res.scanLine(y));
+            for (int x = square.left(); x <= square.right(); x++)
+                line[x] = qRgb(0xff, 0, 0); // NOLINT
+        }
+    }
+    return res;
+}
+
+void BenchChangeDetector::addFrameRows()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<bool>("changed");
+
+    QTest::newRow("1080p unchanged") << QSize(1920, 1080) << false;
+    QTest::newRow("1080p changed") << QSize(1920, 1080) << true;
+    QTest::newRow("4K unchanged") << QSize(3840, 2160) << false;
+    QTest::newRow("4K changed") << QSize(3840, 2160) << true;
+}
+
+void BenchChangeDetector::qimageCompare_data()
+{
+    addFrameRows();
+}
+
+void BenchChangeDetector::qimageCompare()
+{
+    QFETCH(QSize, size);
+    QFETCH(bool, changed);
+
+    const QImage frames[2] = { testFrame(size, false), testFrame(size, changed) };
+    QImage saved = frames[0].copy();
+    int index = 1;
+
+    QBENCHMARK {
+        const QImage &frame = frames[index];
+        if (frame != saved)
+            saved = frame.copy();
+        index ^= 1;
+    }
+}
+
+void BenchChangeDetector::tileHashes_data()
+{
+    addFrameRows();
+}
+
+void BenchChangeDetector::tileHashes()
+{
+    QFETCH(QSize, size);
+    QFETCH(bool, changed);
+
+    const QImage frames[2] = { testFrame(size, false), testFrame(size, changed) };
+    ZChangeDetector detector;
+    detector.update(frames[0]);
+    int index = 1;
+    int updates = 0;
+
+    QBENCHMARK {
+        if (detector.update(frames[index]))
+            updates++;
+        index ^= 1;
+    }
+
+    QCOMPARE(updates > 0, changed);
+}
+
+QTEST_GUILESS_MAIN(BenchChangeDetector)
+
+#include "bench_changedetector.moc"
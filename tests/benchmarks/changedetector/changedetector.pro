@@ -0,0 +1,6 @@
+include(../../tests.pri)
+
+TARGET = bench_changedetector
+
+SOURCES += \
+    bench_changedetector.cpp
@@ -0,0 +1,94 @@
+#include <QtTest>
+#include <QRandomGenerator>
+#include <QVector>
+
+#include "pixelops.h"
+
+Q_DECLARE_METATYPE(ZPixelOps::ZInstructionSet)
+
+// Pixel kernels on a 4K frame through the same entry points the capture path uses
+class BenchPixelOps : public QObject
+{
+    Q_OBJECT
+
+private:
+    static const int frameWidth = 3840;
+    static const int frameHeight = 2160;
+
+    QVector<quint32> m_frame;
+    QVector<quint32> m_changed;
+
+private Q_SLOTS:
+    void initTestCase();
+    void convertDepth30_data();
+    void convertDepth30();
+    void countChangedPixels_data();
+    void countChangedPixels();
+};
+
+void BenchPixelOps::initTestCase()
+{
+    QRandomGenerator generator(1);
+    m_frame.resize(frameWidth * frameHeight);
+    for (auto &pixel : m_frame)
+        pixel = generator.generate();
+
+    // a typical autocapture difference, a few percent of the frame changed
+    const int changedPercent = 5;
+    const int percent = 100;
+    m_changed = m_frame;
+    for (auto &pixel : m_changed) {
+        if (generator.bounded(percent) < changedPercent)
+            pixel = ~pixel;
+    }
+}
+
+void BenchPixelOps::convertDepth30_data()
+{
+    QTest::addColumn<ZPixelOps::ZInstructionSet>("isa");
+
+    QTest::newRow("scalar") << ZPixelOps::Scalar;
+    QTest::newRow("sse2") << ZPixelOps::SSE2;
+    QTest::newRow("avx2") << ZPixelOps::AVX2;
+}
+
+void BenchPixelOps::convertDepth30()
+{
+    QFETCH(ZPixelOps::ZInstructionSet, isa);
+
+    if (isa > ZPixelOps::bestInstructionSet())
+        QSKIP("Instruction set is not supported by this CPU");
+
+    QVector<quint32> frame = m_frame;
+    const auto count = static_cast<quint32>(frame.size());
+
+    QBENCHMARK {
+        ZPixelOps::convertDepth30(frame.data(), count, isa);
+    }
+}
+
+void BenchPixelOps::countChangedPixels_data()
+{
+    convertDepth30_data();
+}
+
+void BenchPixelOps::countChangedPixels()
+{
+    QFETCH(ZPixelOps::ZInstructionSet, isa);
+
+    if (isa > ZPixelOps::bestInstructionSet())
+        QSKIP("Instruction set is not supported by this CPU");
+
+    const auto count = static_cast<quint32>(m_frame.size());
+    quint32 changed = 0;
+
+    QBENCHMARK {
+        changed = ZPixelOps::countChangedPixels(m_frame.constData(), m_changed.constData(), count, isa);
+    }
+
+    QVERIFY(changed > 0);
+}
+
+QTEST_GUILESS_MAIN(BenchPixelOps)
+
+#include "bench_pixelops.moc"
@@ -0,0 +1,6 @@
+include(../../tests.pri)
+
+TARGET = bench_pixelops
+
+SOURCES += \
+    bench_pixelops.cpp
@@ -0,0 +1,132 @@
+#include <QtTest>
+#include <QImage>
+#include <QImageWriter>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QThreadPool>
+#include <QAtomicInt>
+
+#include "pngwriter.h"
+#include "coredefs.h"
+
+// ZPngWriter against the Qt PNG writer at the same quality setting. The frame
+// is a gradient with rows of noise, so both writers have something to do
+// beyond run lengths. The last case keeps every global pool thread busy with
+// a write of its own, which used to starve the stripe tasks.
+class BenchPngWriter : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+
+    static QImage testFrame(const QSize &size);
+    static void addFrameRows();
+
+private Q_SLOTS:
+    void qtWriter();
+    void qtWriter_data();
+    void pngWriter();
+    void pngWriter_data();
+    void pngWriterFromGlobalPool();
+};
+
+QImage BenchPngWriter::testFrame(const QSize &size)
+{
+    const int noiseRowStep = 8;
+
+    QRandomGenerator generator(1);
+    QImage res(size, QImage::Format_RGB32);
+    for (int y = 0; y < size.height(); y++) {
+        auto *line = reinterpret_cast<QRgb *>(res.scanLine(y));
+        for (int x = 0; x < size.width(); x++) {
+            if ((y % noiseRowStep) == 0) {
+                line[x] = 0xff000000U | generator.bounded(0x1000000U); // NOLINT
+            } else {
+                line[x] = qRgb(x & 0xff, y & 0xff, (x + y) & 0xff); // NOLINT
+            }
+        }
+    }
+    return res;
+}
+
+void BenchPngWriter::addFrameRows()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("quality");
+
+    QTest::newRow("1080p quality 50") << QSize(1920, 1080) << 50;
+    QTest::newRow("1080p quality 20") << QSize(1920, 1080) << 20;
+    QTest::newRow("4K quality 50") << QSize(3840, 2160) << 50;
+    QTest::newRow("4K quality 20") << QSize(3840, 2160) << 20;
+}
+
+void BenchPngWriter::qtWriter_data()
+{
+    addFrameRows();
+}
+
+void BenchPngWriter::qtWriter()
+{
+    QFETCH(QSize, size);
+    QFETCH(int, quality);
+
+    QVERIFY(m_dir.isValid());
+    const QImage frame = testFrame(size);
+    const QString fileName = m_dir.filePath(QSL("qt.png"));
+
+    QBENCHMARK {
+        QImageWriter writer(fileName, "png");
+        writer.setQuality(quality);
+        QVERIFY(writer.write(frame));
+    }
+}
+
+void BenchPngWriter::pngWriter_data()
+{
+    addFrameRows();
+}
+
+void BenchPngWriter::pngWriter()
+{
+    QFETCH(QSize, size);
+    QFETCH(int, quality);
+
+    QVERIFY(m_dir.isValid());
+    const QImage frame = testFrame(size);
+    const QString fileName = m_dir.filePath(QSL("zpng.png"));
+    const int compression = ZPngWriter::compressionFromQuality(quality);
+
+    QBENCHMARK {
+        QString error;
+        QVERIFY2(ZPngWriter::write(frame, fileName, compression, &error), qPrintable(error));
+    }
+
+    // the stitched stream must decode to the same pixels
+    QCOMPARE(QImage(fileName).convertToFormat(QImage::Format_RGB32), frame);
+}
+
+void BenchPngWriter::pngWriterFromGlobalPool()
+{
+    QVERIFY(m_dir.isValid());
+    const QImage frame = testFrame(QSize(1920, 1080));
+    const int compression = ZPngWriter::compressionFromQuality(50); // NOLINT
+    QThreadPool *pool = QThreadPool::globalInstance();
+
+    QBENCHMARK {
+        QAtomicInt failures;
+        for (int i = 0; i < pool->maxThreadCount(); i++) {
+            const QString fileName = m_dir.filePath(QSL("pool%1.png").arg(i));
+            pool->start([&frame, fileName, compression, &failures](){
+                if (!ZPngWriter::write(frame, fileName, compression))
+                    failures.ref();
+            });
+        }
+        pool->waitForDone();
+        QCOMPARE(failures.loadAcquire(), 0);
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchPngWriter)
+
+#include "bench_pngwriter.moc"
@@ -0,0 +1,6 @@
+include(../../tests.pri)
+
+TARGET = bench_pngwriter
+
+SOURCES += \
+    bench_pngwriter.cpp
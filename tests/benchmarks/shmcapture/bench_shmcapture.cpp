@@ -0,0 +1,84 @@
+#include <QtTest>
+#include <QImage>
+#include <QRect>
+
+#include <xcb/xcb.h>
+
+#include "framebuffer.h"
+
+// Compares MIT-SHM grabs against plain xcb_get_image socket transfer.
+// Run it under Xvfb, e.g. `xvfb-run -s "-screen 0 3840x2160x24" ./bench_shmcapture`.
+class BenchShmCapture : public QObject
+{
+    Q_OBJECT
+
+private:
+    xcb_connection_t* m_connection { nullptr };
+    xcb_window_t m_root { 0 };
+    QSize m_rootSize;
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void grab_data();
+    void grab();
+};
+
+void BenchShmCapture::initTestCase()
+{
+    int screenNum = 0;
+    m_connection = xcb_connect(nullptr, &screenNum);
+    if (xcb_connection_has_error(m_connection) != 0)
+        QSKIP("No X server available");
+
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(xcb_get_setup(m_connection));
+    for (; it.rem > 0 && screenNum > 0; --screenNum)
+        xcb_screen_next(&it);
+
+    m_root = it.data->root;
+    m_rootSize = QSize(it.data->width_in_pixels, it.data->height_in_pixels);
+}
+
+void BenchShmCapture::cleanupTestCase()
+{
+    if (m_connection != nullptr)
+        xcb_disconnect(m_connection);
+}
+
+void BenchShmCapture::grab_data()
+{
+    QTest::addColumn<bool>("useShm");
+    QTest::addColumn<QSize>("size");
+
+    const QVector<QSize> sizes({ QSize(640, 480), QSize(1920, 1080), QSize(3840, 2160) });
+    for (const auto &size : sizes) {
+        const QByteArray name = QByteArray::number(size.width()) + 'x' + QByteArray::number(size.height());
+        QTest::newRow(QByteArray("shm " + name).constData()) << true << size;
+        QTest::newRow(QByteArray("socket " + name).constData()) << false << size;
+    }
+}
+
+void BenchShmCapture::grab()
+{
+    QFETCH(bool, useShm);
+    QFETCH(QSize, size);
+
+    if (size.width() > m_rootSize.width() || size.height() > m_rootSize.height())
+        QSKIP("Root window is smaller than the requested grab");
+
+    ZFrameBuffer buffer(m_connection, useShm);
+    if (useShm && !buffer.isShmSupported())
+        QSKIP("MIT-SHM is not available on this display");
+
+    const QRect geometry(QPoint(0, 0), size);
+
+    // the view is dropped before the next grab, so the buffer is reused
+    QBENCHMARK {
+        const QImage image = buffer.grab(m_root, geometry);
+        QVERIFY(!image.isNull());
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchShmCapture)
+
+#include "bench_shmcapture.moc"
@@ -0,0 +1,6 @@
+include(../../tests.pri)
+
+TARGET = bench_shmcapture
+
+SOURCES += \
+    bench_shmcapture.cpp
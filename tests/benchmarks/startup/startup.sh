@@ -0,0 +1,122 @@
+#!/bin/bash
+# Startup time and peak RSS of headless capture against the GUI, both on the
+# same Xvfb server.
+#
+# Headless runs are timed by /usr/bin/time, which also reports the peak RSS.
+# A GUI run is timed until its main window is mapped, the peak RSS is read
+# from VmHWM in /proc before the process is terminated.
+#
+# Usage: startup.sh [path to scrcap] [runs]
+# Requires Xvfb, xwininfo and GNU time.
+
+set -euo pipefail
+
+SCRCAP=$(readlink -f "${1:-../../../app/scrcap}")
+RUNS=${2:-10}
+SCREEN_SIZE=1920x1080x24
+WINDOW_TIMEOUT=10
+
+if [ ! -x "${SCRCAP}" ]; then
+    echo "scrcap binary not found: ${SCRCAP}" >&2
+    exit 1
+fi
+
+for tool in Xvfb xwininfo /usr/bin/time; do
+    if ! command -v "${tool}" > /dev/null; then
+        echo "${tool} is required" >&2
+        exit 1
+    fi
+done
+
+WORKDIR=$(mktemp -d)
+XVFB_PID=
+
+cleanup() {
+    if [ -n "${XVFB_PID}" ]; then
+        kill "${XVFB_PID}" 2> /dev/null || true
+        wait "${XVFB_PID}" 2> /dev/null || true
+    fi
+    rm -rf "${WORKDIR}"
+}
+trap cleanup EXIT
+
+# the settings of the user must not change the GUI startup path
+export XDG_CONFIG_HOME="${WORKDIR}/config"
+mkdir -p "${XDG_CONFIG_HOME}"
+
+Xvfb -displayfd 3 -screen 0 "${SCREEN_SIZE}" -nolisten tcp 3> "${WORKDIR}/display" 2> /dev/null &
+XVFB_PID=$!
+while [ ! -s "${WORKDIR}/display" ]; do
+    sleep 0.1
+done
+export DISPLAY=":$(cat "${WORKDIR}/display")"
+
+now() {
+    date +%s.%N
+}
+
+# Seconds since the given start time
+since() {
+    awk -v start="$1" -v end="$(now)" 'BEGIN { printf "%.3f", end - start }'
+}
+
+# Prints "seconds kilobytes" for one headless snapshot
+headless_run() {
+    /usr/bin/time -f "%e %M" -o "${WORKDIR}/time" \
+        "${SCRCAP}" --headless --mode fullscreen --output "${WORKDIR}/shot.png" 2> /dev/null
+    cat "${WORKDIR}/time"
+}
+
+# Succeeds when the GUI main window is mapped. Qt appends the application
+# display name to the title, "Screen capture — ScrCap". The window is listed
+# by the tree as soon as it is created, so its map state is checked too.
+gui_mapped() {
+    local id
+    id=$(xwininfo -root -tree 2> /dev/null | awk '/ScrCap": \(/ { print $1; exit }')
+    [ -n "${id}" ] && xwininfo -id "${id}" 2> /dev/null | grep -q 'Map State: IsViewable'
+}
+
+# Prints "seconds kilobytes" for the GUI up to its mapped main window
+gui_run() {
+    local start pid elapsed hwm
+    start=$(now)
+    "${SCRCAP}" > /dev/null 2>&1 &
+    pid=$!
+
+    until gui_mapped; do
+        if ! kill -0 "${pid}" 2> /dev/null; then
+            echo "scrcap GUI exited before showing its window" >&2
+            exit 1
+        fi
+        if awk -v elapsed="$(since "${start}")" -v limit="${WINDOW_TIMEOUT}" \
+                'BEGIN { exit !(elapsed > limit) }'; then
+            echo "scrcap GUI window did not appear in ${WINDOW_TIMEOUT} s" >&2
+            kill "${pid}"
+            exit 1
+        fi
+        sleep 0.01
+    done
+    elapsed=$(since "${start}")
+
+    hwm=$(awk '/^VmHWM:/ { print $2 }' "/proc/${pid}/status")
+    kill "${pid}"
+    wait "${pid}" 2> /dev/null || true
+
+    echo "${elapsed} ${hwm}"
+}
+
+# Runs one mode RUNS times and prints the mean and the maximum
+measure() {
+    local name=$1 run=$2 i
+    for ((i = 0; i < RUNS; i++)); do
+        "${run}"
+    done | awk -v name="${name}" '
+        { time += $1; rss += $2; if ($2 > maxrss) maxrss = $2 }
+        END { if (NR == 0) exit 1
+              printf "%-10s mean %.3f s, mean VmHWM %d KiB, max VmHWM %d KiB\n",
+                     name, time / NR, rss / NR, maxrss }'
+}
+
+echo "${SCRCAP}, ${RUNS} runs, Xvfb ${SCREEN_SIZE}"
+measure headless headless_run
+measure gui gui_run
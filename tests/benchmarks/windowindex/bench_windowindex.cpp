@@ -0,0 +1,157 @@
+#include <QtTest>
+#include <QRandomGenerator>
+#include <QVector>
+#include <QRect>
+
+#include <algorithm>
+
+#include "windowindex.h"
+
+// ZWindowIndex against the linear scans WindowGrabber used before, on 3000
+// synthetic windows: 300 overlapping top-level windows over a 7680x2160
+// desktop, each with a chain of 9 nested children.
+class BenchWindowIndex : public QObject
+{
+    Q_OBJECT
+
+private:
+    static const int topLevelCount = 300;
+    static const int nestingDepth = 10;
+    static const int queryCount = 1000;
+
+    QVector<QRect> m_windows;
+    QVector<QPoint> m_points;
+
+    int linearWindowAt(const QPoint &pos) const;
+    int linearLargerWindowAt(const QPoint &pos, int current) const;
+
+private Q_SLOTS:
+    void initTestCase();
+    void build();
+    void windowAtLinear();
+    void windowAtIndex();
+    void scopeWalkLinear();
+    void scopeWalkIndex();
+};
+
+int BenchWindowIndex::linearWindowAt(const QPoint &pos) const
+{
+    for (int i = 0; i < m_windows.size(); i++) {
+        if (m_windows.at(i).contains(pos))
+            return i;
+    }
+    return -1;
+}
+
+int BenchWindowIndex::linearLargerWindowAt(const QPoint &pos, int current) const
+{
+    for (int i = current + 1; i < m_windows.size(); i++) {
+        if (m_windows.at(i).contains(pos))
+            return i;
+    }
+    return current;
+}
+
+void BenchWindowIndex::initTestCase()
+{
+    const QRect desktop(0, 0, 7680, 2160);
+    const int minTopLevelSize = 200;
+    const int maxTopLevelSize = 1600;
+    const int inset = 8;
+
+    QRandomGenerator generator(1);
+    for (int i = 0; i < topLevelCount; i++) {
+        const int width = generator.bounded(minTopLevelSize, maxTopLevelSize);
+        const int height = generator.bounded(minTopLevelSize, maxTopLevelSize);
+        QRect r(generator.bounded(desktop.width() - width), generator.bounded(desktop.height() - height),
+                width, height);
+        for (int depth = 0; depth < nestingDepth; depth++) {
+            m_windows.append(r);
+            r = r.adjusted(inset, inset * 2, -inset * 2, -inset);
+        }
+    }
+
+    // the same order ZXCBTools::getWindowsRecursive returns
+    std::stable_sort(m_windows.begin(), m_windows.end(), [](const QRect &r1, const QRect &r2) {
+        return r1.width() * r1.height() < r2.width() * r2.height();
+    });
+
+    for (int i = 0; i < queryCount; i++)
+        m_points.append(QPoint(generator.bounded(desktop.width()), generator.bounded(desktop.height())));
+
+    // both ways must agree before they are timed
+    const ZWindowIndex index(m_windows);
+    for (const auto &pos : std::as_const(m_points)) {
+        QCOMPARE(index.windowAt(pos), linearWindowAt(pos));
+        const int smallest = index.windowAt(pos);
+        QCOMPARE(index.largerWindowAt(pos, smallest), linearLargerWindowAt(pos, smallest));
+    }
+}
+
+void BenchWindowIndex::build()
+{
+    QBENCHMARK {
+        const ZWindowIndex index(m_windows);
+        Q_UNUSED(index)
+    }
+}
+
+void BenchWindowIndex::windowAtLinear()
+{
+    int found = 0;
+    QBENCHMARK {
+        for (const auto &pos : std::as_const(m_points))
+            found += linearWindowAt(pos);
+    }
+    QVERIFY(found != 0);
+}
+
+void BenchWindowIndex::windowAtIndex()
+{
+    const ZWindowIndex index(m_windows);
+    int found = 0;
+    QBENCHMARK {
+        for (const auto &pos : std::as_const(m_points))
+            found += index.windowAt(pos);
+    }
+    QVERIFY(found != 0);
+}
+
+// From the smallest window under each point up to the largest one,
+// as wheel scrolling in WindowGrabber does
+void BenchWindowIndex::scopeWalkLinear()
+{
+    int steps = 0;
+    QBENCHMARK {
+        for (const auto &pos : std::as_const(m_points)) {
+            int current = linearWindowAt(pos);
+            for (int next = linearLargerWindowAt(pos, current); next != current;
+                 next = linearLargerWindowAt(pos, current)) {
+                current = next;
+                steps++;
+            }
+        }
+    }
+    QVERIFY(steps > 0);
+}
+
+void BenchWindowIndex::scopeWalkIndex()
+{
+    const ZWindowIndex index(m_windows);
+    int steps = 0;
+    QBENCHMARK {
+        for (const auto &pos : std::as_const(m_points)) {
+            int current = index.windowAt(pos);
+            for (int next = index.largerWindowAt(pos, current); next != current;
+                 next = index.largerWindowAt(pos, current)) {
+                current = next;
+                steps++;
+            }
+        }
+    }
+    QVERIFY(steps > 0);
+}
+
+QTEST_GUILESS_MAIN(BenchWindowIndex)
+
+#include "bench_windowindex.moc"
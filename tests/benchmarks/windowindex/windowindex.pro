@@ -0,0 +1,6 @@
+include(../../tests.pri)
+
+TARGET = bench_windowindex
+
+SOURCES += \
+    bench_windowindex.cpp
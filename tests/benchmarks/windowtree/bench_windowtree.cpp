@@ -0,0 +1,179 @@
+#include <QtTest>
+#include <QScopedPointer>
+#include <QVector>
+#include <QRect>
+
+#include <algorithm>
+
+#include <xcb/xcb.h>
+
+#include "xcbtools.h"
+#include "windowtree.h"
+
+// Window list collection over a synthetic tree of 2050 mapped windows:
+// the old walk with one blocking round trip per request, the breadth-first
+// batched walk and the live window tree cache.
+// Run it under Xvfb, e.g. `xvfb-run ./bench_windowtree`.
+class BenchWindowTree : public QObject
+{
+    Q_OBJECT
+
+private:
+    static const int topLevelCount = 50;
+    static const int childCount = 20;
+    static const int minSize = 8;
+
+    xcb_connection_t* m_connection { nullptr };
+    xcb_window_t m_root { 0 };
+    int m_expectedCount { 0 };
+
+    xcb_window_t createWindow(xcb_window_t parent, const QRect &geometry);
+    void perNodeWalk(QVector<QRect> &windows, xcb_window_t w, int rx, int ry, int depth);
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void perNodeRoundTrips();
+    void batchedLevels();
+    void liveTree();
+};
+
+xcb_window_t BenchWindowTree::createWindow(xcb_window_t parent, const QRect &geometry)
+{
+    const uint32_t overrideRedirect = 1;
+
+    const xcb_window_t window = xcb_generate_id(m_connection);
+    xcb_create_window(m_connection, XCB_COPY_FROM_PARENT, window, parent,
+                      static_cast<int16_t>(geometry.x()), static_cast<int16_t>(geometry.y()),
+                      static_cast<uint16_t>(geometry.width()), static_cast<uint16_t>(geometry.height()),
+                      0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT,
+                      XCB_CW_OVERRIDE_REDIRECT, &overrideRedirect);
+    return window;
+}
+
+// The walk as it was before batching, kept here as the baseline
+void BenchWindowTree::perNodeWalk(QVector<QRect> &windows, xcb_window_t w, int rx, int ry, int depth)
+{
+    xcb_get_window_attributes_cookie_t ac = xcb_get_window_attributes_unchecked(m_connection, w);
+    QScopedPointer<xcb_get_window_attributes_reply_t,QScopedPointerPodDeleter>
+            atts(xcb_get_window_attributes_reply(m_connection, ac, nullptr));
+
+    xcb_get_geometry_cookie_t gc = xcb_get_geometry_unchecked(m_connection, w);
+    QScopedPointer<xcb_get_geometry_reply_t,QScopedPointerPodDeleter>
+            geom(xcb_get_geometry_reply(m_connection, gc, nullptr));
+
+    if (atts && geom && atts->map_state == XCB_MAP_STATE_VIEWABLE &&
+            geom->width >= minSize && geom->height >= minSize) {
+        int x = 0;
+        int y = 0;
+        if (depth != 0) {
+            x = geom->x + rx;
+            y = geom->y + ry;
+        }
+
+        const QRect r(x, y, geom->width, geom->height);
+        if (!windows.contains(r))
+            windows.append(r);
+
+        xcb_query_tree_cookie_t tc = xcb_query_tree_unchecked(m_connection, w);
+        QScopedPointer<xcb_query_tree_reply_t,QScopedPointerPodDeleter>
+                tree(xcb_query_tree_reply(m_connection, tc, nullptr));
+
+        if (tree) {
+            xcb_window_t* child = xcb_query_tree_children(tree.data());
+            for (unsigned int i = 0; i < tree->children_len; i++)
+                perNodeWalk(windows, child[i], x, y, depth + 1); // NOLINT
+        }
+    }
+
+    if (depth == 0) {
+        std::sort(windows.begin(), windows.end(), [](const QRect &r1, const QRect &r2) {
+            return r1.width() * r1.height() < r2.width() * r2.height();
+        });
+    }
+}
+
+void BenchWindowTree::initTestCase()
+{
+    const int topLevelSize = 200;
+    const int childSize = 40;
+    const int grandChildSize = 16;
+    const int spread = 11;
+
+    int screenNum = 0;
+    m_connection = xcb_connect(nullptr, &screenNum);
+    if (xcb_connection_has_error(m_connection) != 0)
+        QSKIP("No X server available");
+
+    m_root = ZXCBTools::appRootWindow();
+
+    // every window gets a distinct root-relative rect, so none is deduplicated
+    for (int i = 0; i < topLevelCount; i++) {
+        const xcb_window_t topLevel = createWindow(m_root, QRect(i * spread, i * spread,
+                                                                 topLevelSize + i, topLevelSize + i));
+        for (int j = 0; j < childCount; j++) {
+            const xcb_window_t child = createWindow(topLevel, QRect(j * spread % topLevelSize, j,
+                                                                    childSize + j, childSize));
+            createWindow(child, QRect(1, 1, grandChildSize + j, grandChildSize));
+            xcb_map_subwindows(m_connection, child);
+        }
+        xcb_map_subwindows(m_connection, topLevel);
+        xcb_map_window(m_connection, topLevel);
+    }
+
+    QScopedPointer<xcb_get_input_focus_reply_t,QScopedPointerPodDeleter>
+            sync(xcb_get_input_focus_reply(m_connection, xcb_get_input_focus(m_connection), nullptr));
+
+    QVector<QRect> windows;
+    perNodeWalk(windows, m_root, 0, 0, 0);
+    m_expectedCount = windows.count();
+    QVERIFY(m_expectedCount > topLevelCount * childCount * 2);
+}
+
+void BenchWindowTree::cleanupTestCase()
+{
+    if (m_connection != nullptr)
+        xcb_disconnect(m_connection);
+}
+
+void BenchWindowTree::perNodeRoundTrips()
+{
+    QVector<QRect> windows;
+    QBENCHMARK {
+        windows.clear();
+        perNodeWalk(windows, m_root, 0, 0, 0);
+    }
+    QCOMPARE(windows.count(), m_expectedCount);
+}
+
+void BenchWindowTree::batchedLevels()
+{
+    QVector<QRect> windows;
+    QBENCHMARK {
+        windows.clear();
+        ZXCBTools::queryWindowsRecursive(windows, m_root);
+    }
+    QCOMPARE(windows.count(), m_expectedCount);
+}
+
+void BenchWindowTree::liveTree()
+{
+    // the tree may still be catching up with the windows created above
+    const auto isTreeComplete = [this]() {
+        QVector<QRect> list;
+        return ZXCBTools::windowTree()->collectWindows(list, m_root, 0, 0, 0, minSize) &&
+                (list.count() == m_expectedCount);
+    };
+    QTRY_VERIFY(isTreeComplete());
+
+    QVector<QRect> windows;
+    QBENCHMARK {
+        windows.clear();
+        ZXCBTools::getWindowsRecursive(windows, m_root);
+    }
+    QCOMPARE(windows.count(), m_expectedCount);
+}
+
+QTEST_GUILESS_MAIN(BenchWindowTree)
+
+#include "bench_windowtree.moc"
@@ -0,0 +1,6 @@
+include(../../tests.pri)
+
+TARGET = bench_windowtree
+
+SOURCES += \
+    bench_windowtree.cpp
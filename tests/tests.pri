@@ -0,0 +1,11 @@
+include($$PWD/../scrcap.pri)
+
+TEMPLATE = app
+
+QT += testlib
+CONFIG += console
+CONFIG -= app_bundle
+
+# every test lives two levels below tests/, so core is three levels up
+LIBS += -L$$OUT_PWD/../../../core -lscrcapcore
+PRE_TARGETDEPS += $$OUT_PWD/../../../core/libscrcapcore.a
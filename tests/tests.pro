@@ -0,0 +1,6 @@
+TEMPLATE = subdirs
+
+# unit tests (make check) and benchmarks against the core library
+SUBDIRS += \
+    auto \
+    benchmarks